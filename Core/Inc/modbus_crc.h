@@ -0,0 +1,89 @@
+
+
+#ifndef MODBUS_CRC_H
+#define MODBUS_CRC_H
+
+/*
+ * modbus_crc.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdint.h>
+
+// No HAL dependency: the backends also build on the host, see Tests/
+
+// CRC-16/MODBUS: reflected poly 0xA001, init 0xFFFF, low byte sent first
+#define MODBUS_CRC_INIT          0xFFFF
+#define MODBUS_CRC_POLY          0xA001
+
+// CRC backends, pick one with MODBUS_CRC_BACKEND (flash cost in brackets)
+#define MODBUS_CRC_BITWISE       0    // 8 shift/xor per byte [0 bytes]
+#define MODBUS_CRC_NIBBLE        1    // 2 lookups per byte [32 bytes]
+#define MODBUS_CRC_TABLE         2    // 1 lookup per byte [512 bytes]
+#define MODBUS_CRC_SLICE4        3    // 4 lookups per 4 bytes [2 KB]
+
+#ifndef MODBUS_CRC_BACKEND
+#define MODBUS_CRC_BACKEND       MODBUS_CRC_TABLE
+#endif
+
+// Compile-time table generation
+
+template <unsigned N>
+struct ModbusCRC_Table {
+    uint16_t v[N];
+};
+
+constexpr uint16_t ModbusCRC_ShiftBits(uint16_t crc, unsigned bits) {
+    for (unsigned i = 0; i < bits; i++) {
+        crc = (crc & 0x0001) ? (uint16_t)((crc >> 1) ^ MODBUS_CRC_POLY) : (uint16_t)(crc >> 1);
+    }
+    return crc;
+}
+
+// Entry i is the CRC contribution of a 4-bit (N=16) or 8-bit (N=256) value
+template <unsigned N>
+constexpr ModbusCRC_Table<N> ModbusCRC_MakeTable() {
+    ModbusCRC_Table<N> table {};
+    for (unsigned i = 0; i < N; i++) {
+        table.v[i] = ModbusCRC_ShiftBits((uint16_t)i, (N == 16) ? 4 : 8);
+    }
+    return table;
+}
+
+// Slice k gives the contribution of a byte followed by k more bytes
+constexpr ModbusCRC_Table<4 * 256> ModbusCRC_MakeSlice4() {
+    ModbusCRC_Table<4 * 256> table {};
+    for (unsigned i = 0; i < 256; i++) {
+        table.v[i] = ModbusCRC_ShiftBits((uint16_t)i, 8);
+    }
+    for (unsigned k = 1; k < 4; k++) {
+        for (unsigned i = 0; i < 256; i++) {
+            uint16_t prev = table.v[(k - 1) * 256 + i];
+            table.v[k * 256 + i] = (uint16_t)((prev >> 8) ^ table.v[prev & 0xFF]);
+        }
+    }
+    return table;
+}
+
+// Reference implementation usable in constant expressions
+constexpr uint16_t ModbusCRC_Constexpr(const char *data, uint16_t length, uint16_t crc = MODBUS_CRC_INIT) {
+    for (uint16_t i = 0; i < length; i++) {
+        crc = ModbusCRC_ShiftBits((uint16_t)(crc ^ (uint8_t)data[i]), 8);
+    }
+    return crc;
+}
+
+static_assert(ModbusCRC_Constexpr("123456789", 9) == 0x4B37, "CRC-16/MODBUS check value");
+
+// Functions
+
+uint16_t ModbusCRC_UpdateBitwise(uint16_t crc, const uint8_t *buffer, uint16_t length);
+uint16_t ModbusCRC_UpdateNibble(uint16_t crc, const uint8_t *buffer, uint16_t length);
+uint16_t ModbusCRC_UpdateTable(uint16_t crc, const uint8_t *buffer, uint16_t length);
+uint16_t ModbusCRC_UpdateSlice4(uint16_t crc, const uint8_t *buffer, uint16_t length);
+uint16_t ModbusCRC_Update(uint16_t crc, const uint8_t *buffer, uint16_t length);
+uint16_t Modbus_CalculateCRC(const uint8_t *buffer, uint16_t length);
+
+#endif  // MODBUS_CRC_H
@@ -0,0 +1,147 @@
+
+
+#ifndef MODBUS_FRAME_H
+#define MODBUS_FRAME_H
+
+/*
+ * modbus_frame.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdint.h>
+#include "modbus_crc.h"
+#include "modbus_master.h"
+#include "modbus_motor.h"
+
+// Typed RTU frame layouts, one specialisation per function code.
+//
+// Write() lays a request ADU (address, PDU and CRC) straight into 'frame',
+// normally a TX slot from ModbusRTU_ClaimFrame, and returns its length or 0
+// when the request does not fit the layout. Parse() reads a reply in place,
+// normally the RX slot returned by ModbusRTU_PeekReply; address, function code
+// and CRC have already been checked, and lengths include the 2 CRC bytes.
+
+static inline void ModbusFrame_PutWord(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+
+static inline uint16_t ModbusFrame_GetWord(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+// Appends the CRC (low byte first) to 'length' bytes and returns the ADU length
+static inline uint16_t ModbusFrame_Seal(uint8_t *frame, uint16_t length) {
+    uint16_t crc = Modbus_CalculateCRC(frame, length);
+    frame[length] = crc & 0xFF;
+    frame[length + 1] = (crc >> 8) & 0xFF;
+    return length + 2;
+}
+
+// Address, function code and two 16-bit fields: every fixed 6-byte request
+static inline uint16_t ModbusFrame_WriteHeader(uint8_t *frame, const Modbus_Request *request) {
+    frame[0] = request->slaveID;
+    frame[1] = request->functionCode;
+    ModbusFrame_PutWord(&frame[2], request->regAddress);
+    ModbusFrame_PutWord(&frame[4], request->value);
+    return 6;
+}
+
+// Byte count followed by registers (FC03 and FC23 replies)
+static inline Modbus_Status ModbusFrame_ParseRegisters(const uint8_t *frame, uint16_t length,
+                                                       Modbus_Response *result) {
+    uint8_t byteCount = frame[2];
+    if ((byteCount & 1) || byteCount > MODBUS_MAX_READ_REGS * 2 || length != 3 + byteCount + 2) {
+        return MODBUS_ERR_LENGTH;
+    }
+    result->count = byteCount / 2;
+    for (uint8_t i = 0; i < result->count; i++) {
+        result->registers[i] = ModbusFrame_GetWord(&frame[3 + i * 2]);
+    }
+    return MODBUS_OK;
+}
+
+// Address and value/quantity echo (FC06 and FC16 replies)
+static inline Modbus_Status ModbusFrame_ParseEcho(const uint8_t *frame, uint16_t length, Modbus_Response *result) {
+    if (length != 8) {
+        return MODBUS_ERR_LENGTH;
+    }
+    result->regAddress = ModbusFrame_GetWord(&frame[2]);
+    result->value = ModbusFrame_GetWord(&frame[4]);
+    return MODBUS_OK;
+}
+
+template <uint8_t FC>
+struct Modbus_Frame;
+
+template <>
+struct Modbus_Frame<MODBUS_READ_HOLDING_REG> {
+    // slave, 0x03, start, quantity, CRC -> slave, 0x03, byte count, registers, CRC
+    static uint16_t Write(uint8_t *frame, const Modbus_Request *request) {
+        if (request->value == 0 || request->value > MODBUS_MAX_READ_REGS) {
+            return 0;
+        }
+        return ModbusFrame_Seal(frame, ModbusFrame_WriteHeader(frame, request));
+    }
+    static Modbus_Status Parse(const uint8_t *frame, uint16_t length, Modbus_Response *result) {
+        return ModbusFrame_ParseRegisters(frame, length, result);
+    }
+};
+
+template <>
+struct Modbus_Frame<MODBUS_WRITE_SINGLE_REG> {
+    // slave, 0x06, address, value, CRC -> echoed unchanged
+    static uint16_t Write(uint8_t *frame, const Modbus_Request *request) {
+        return ModbusFrame_Seal(frame, ModbusFrame_WriteHeader(frame, request));
+    }
+    static Modbus_Status Parse(const uint8_t *frame, uint16_t length, Modbus_Response *result) {
+        return ModbusFrame_ParseEcho(frame, length, result);
+    }
+};
+
+template <>
+struct Modbus_Frame<MODBUS_WRITE_MULTI_REG> {
+    // slave, 0x10, start, quantity, byte count, values, CRC -> slave, 0x10, start, quantity, CRC
+    static uint16_t Write(uint8_t *frame, const Modbus_Request *request) {
+        if (request->value == 0 || request->value > MODBUS_MAX_WRITE_REGS || request->values == NULL) {
+            return 0;
+        }
+        ModbusFrame_WriteHeader(frame, request);
+        frame[6] = (uint8_t)(request->value * 2);
+        for (uint16_t i = 0; i < request->value; i++) {
+            ModbusFrame_PutWord(&frame[7 + i * 2], request->values[i]);
+        }
+        return ModbusFrame_Seal(frame, 7 + request->value * 2);
+    }
+    static Modbus_Status Parse(const uint8_t *frame, uint16_t length, Modbus_Response *result) {
+        return ModbusFrame_ParseEcho(frame, length, result);
+    }
+};
+
+template <>
+struct Modbus_Frame<MODBUS_READ_WRITE_MULTI_REG> {
+    // slave, 0x17, read start, read quantity, write start, write quantity,
+    // byte count, values, CRC -> same reply layout as FC03. The drive performs
+    // the write before the read.
+    static uint16_t Write(uint8_t *frame, const Modbus_Request *request) {
+        if (request->value == 0 || request->value > MODBUS_MAX_READ_REGS || request->writeCount == 0
+            || request->writeCount > MODBUS_MAX_RW_WRITE_REGS || request->values == NULL) {
+            return 0;
+        }
+        ModbusFrame_WriteHeader(frame, request);
+        ModbusFrame_PutWord(&frame[6], request->writeAddress);
+        ModbusFrame_PutWord(&frame[8], request->writeCount);
+        frame[10] = (uint8_t)(request->writeCount * 2);
+        for (uint16_t i = 0; i < request->writeCount; i++) {
+            ModbusFrame_PutWord(&frame[11 + i * 2], request->values[i]);
+        }
+        return ModbusFrame_Seal(frame, 11 + request->writeCount * 2);
+    }
+    static Modbus_Status Parse(const uint8_t *frame, uint16_t length, Modbus_Response *result) {
+        return ModbusFrame_ParseRegisters(frame, length, result);
+    }
+};
+
+#endif  // MODBUS_FRAME_H
@@ -0,0 +1,156 @@
+
+
+#ifndef MODBUS_MASTER_H
+#define MODBUS_MASTER_H
+
+/*
+ * modbus_master.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdint.h>
+#include "main.h"
+#include "modbus_rtu.h"
+
+#define MODBUS_EXCEPTION_FLAG    0x80
+#define MODBUS_MAX_READ_REGS     125  // FC03 quantity limit from the Modbus spec
+#define MODBUS_BROADCAST_ID      0
+#define MODBUS_MAX_SLAVE_ID      247
+
+// Adaptive response timeout (RFC 6298 style), all times in microseconds
+#define MODBUS_RTO_INITIAL_US    10000  // Before the first RTT sample
+#define MODBUS_RTO_MIN_US        1000
+#define MODBUS_RTO_MAX_US        50000
+#define MODBUS_BROADCAST_TURNAROUND_US 100000  // Bus held after a broadcast so every slave can act on it (spec: 100-200 ms)
+#define MODBUS_RTO_GRANULARITY_US 250   // Floor for the 4*RTTVAR term
+#define MODBUS_MAX_RETRIES       2      // Extra attempts after the first
+#define MODBUS_OFFLINE_AFTER     3      // Failed transactions before retries stop
+#define MODBUS_PIPELINE_DEPTH    4      // Requests queued ahead by Modbus_TransactionBatch
+// Queue wait: each frame ahead may hold the line for its longest reply, or for
+// the turnaround delay if it is a broadcast
+#define MODBUS_TX_WAIT_US        (MODBUS_PIPELINE_DEPTH * ((MODBUS_BROADCAST_TURNAROUND_US > MODBUS_RTO_MAX_US) \
+                                  ? MODBUS_BROADCAST_TURNAROUND_US : MODBUS_RTO_MAX_US))
+
+// Bus discovery
+#define MODBUS_SCAN_FIRST_US     3000   // First pass reply window per ID
+#define MODBUS_SCAN_CONFIRM_US   MODBUS_RTO_INITIAL_US  // Second pass, candidates only
+#define MODBUS_SCAN_MAX_FOUND    32
+
+// Shadow of last-acknowledged register values, shared by all slaves on all buses
+#define MODBUS_SHADOW_ENTRIES    32
+
+// Modbus exception codes returned by the drive
+#define MODBUS_EX_ILLEGAL_FUNCTION   0x01
+#define MODBUS_EX_ILLEGAL_ADDRESS    0x02
+#define MODBUS_EX_ILLEGAL_VALUE      0x03
+#define MODBUS_EX_DEVICE_FAILURE     0x04
+#define MODBUS_EX_ACKNOWLEDGE        0x05
+#define MODBUS_EX_DEVICE_BUSY        0x06
+
+typedef enum {
+    MODBUS_OK = 0,
+    MODBUS_ERR_TIMEOUT,       // No reply within the response timeout
+    MODBUS_ERR_CRC,           // A reply arrived but failed the CRC check
+    MODBUS_ERR_SLAVE,         // Reply came from a different slave ID
+    MODBUS_ERR_FUNCTION,      // Reply function code does not match the request
+    MODBUS_ERR_LENGTH,        // Byte count or frame length inconsistent
+    MODBUS_ERR_ECHO,          // FC06/FC16 echo does not match the request
+    MODBUS_ERR_EXCEPTION,     // Drive answered with an exception frame
+    MODBUS_ERR_QUEUE_FULL     // Our TX queue had no room; nothing was sent
+} Modbus_Status;
+
+typedef struct {
+    uint8_t slaveID;
+    uint8_t functionCode;
+    uint16_t regAddress;
+    uint16_t value;           // FC06 value, FC03/FC16/FC23 (read) register quantity
+    const uint16_t *values;   // FC16 data, 'value' registers long; FC23 data, 'writeCount' long
+    uint8_t priority;         // MODBUS_PRIO_* TX lane
+    uint8_t bus;              // MODBUS_BUS_* the slave is wired to
+    uint16_t writeAddress;    // FC23 write start
+    uint16_t writeCount;      // FC23 write quantity
+} Modbus_Request;
+
+typedef struct {
+    Modbus_Status status;
+    uint8_t slaveID;
+    uint8_t functionCode;
+    uint8_t exceptionCode;    // Valid when status is MODBUS_ERR_EXCEPTION
+    uint16_t regAddress;      // FC06/FC16 echo
+    uint16_t value;           // FC06 echoed value, FC16 echoed quantity
+    uint8_t count;            // FC03/FC23 registers returned
+    uint16_t registers[MODBUS_MAX_READ_REGS];
+} Modbus_Response;
+
+// Per-slave round-trip estimates and transaction counters, kept per bus
+typedef struct {
+    uint32_t srttUs;          // Smoothed RTT, 0 until the first sample
+    uint32_t rttvarUs;        // RTT mean deviation
+    uint32_t rtoUs;           // Current response timeout
+    uint32_t lastRttUs;
+    uint32_t samples;
+    uint32_t transactions;
+    uint32_t retries;
+    uint32_t timeouts;
+    uint32_t failures;        // Transactions that gave up after all retries
+    uint8_t consecutiveFailures;
+} Modbus_SlaveStats;
+
+// Redundant-write suppression counters
+typedef struct {
+    uint32_t hits;            // Writes dropped because the drive already holds the value
+    uint32_t misses;          // Writes that had to go out
+    uint32_t updates;         // Values learned from acknowledged writes and reads
+    uint32_t invalidations;   // Entries dropped after errors, alarms or unacknowledged writes
+} Modbus_ShadowStats;
+
+// Drives found by Modbus_Scan
+typedef struct {
+    uint8_t count;
+    uint8_t candidates;       // IDs that showed any sign of life in the first pass
+    uint32_t durationMs;
+    uint8_t slaveID[MODBUS_SCAN_MAX_FOUND];
+    uint32_t rttUs[MODBUS_SCAN_MAX_FOUND];
+} Modbus_ScanResult;
+
+// Frame bytes copied per FC03 transaction, see Modbus_CopyBenchmark. Both
+// counts include the receive ISR's copy of the reply out of the DMA ring; the
+// RX slot it lands in is what the zero-copy path parses.
+typedef struct {
+    uint32_t stagedBytes;     // Built on the stack, copied into the TX queue, reply copied to a slot and out
+    uint32_t zeroCopyBytes;   // Built in the TX slot, reply copied to a slot and parsed there
+    Modbus_Status stagedStatus;
+    Modbus_Status zeroCopyStatus;
+} Modbus_CopyBenchResult;
+
+// Functions
+
+Modbus_Status Modbus_ParseResponse(const uint8_t *frame, uint16_t length, uint8_t slaveID,
+                                   uint8_t functionCode, Modbus_Response *result);
+Modbus_Status Modbus_ReceiveResponse(uint8_t bus, uint8_t slaveID, uint8_t functionCode,
+                                     uint32_t timeoutMs, Modbus_Response *result);
+uint16_t Modbus_BuildRequest(const Modbus_Request *request, uint8_t *frame);
+HAL_StatusTypeDef Modbus_QueueRequest(const Modbus_Request *request);
+HAL_StatusTypeDef Modbus_QueueEmergency(const Modbus_Request *request);
+// Interrupt-safe queueing in the request's own lane. The shadow is not told;
+// streamed registers must be kept out of it (see Modbus_ShadowInvalidate).
+HAL_StatusTypeDef Modbus_QueueStream(const Modbus_Request *request);
+// While held, Modbus_QueueStream answers HAL_BUSY for the bus and streamers
+// retry on their next tick; used around anything that needs the line quiet
+void Modbus_HoldStreams(uint8_t bus, uint8_t hold);
+Modbus_Status Modbus_Transaction(const Modbus_Request *request, Modbus_Response *result);
+// Requests for different buses in one batch run on their lines concurrently
+uint8_t Modbus_TransactionBatch(const Modbus_Request *requests, Modbus_Response *results, uint8_t count);
+const Modbus_SlaveStats *Modbus_GetSlaveStats(uint8_t bus, uint8_t slaveID);
+void Modbus_ResetSlaveStats(uint8_t bus, uint8_t slaveID);
+uint8_t Modbus_ShadowMatch(uint8_t bus, uint8_t slaveID, uint16_t regAddress, uint16_t value);
+void Modbus_ShadowInvalidate(uint8_t bus, uint8_t slaveID);
+void Modbus_GetShadowStats(Modbus_ShadowStats *stats);
+uint8_t Modbus_Scan(uint8_t bus, uint16_t regAddress, Modbus_ScanResult *result);
+// One read of 'count' registers each way; needs a live slave
+void Modbus_CopyBenchmark(uint8_t bus, uint8_t slaveID, uint16_t regAddress, uint8_t count,
+                          Modbus_CopyBenchResult *result);
+
+#endif  // MODBUS_MASTER_H
@@ -12,13 +12,29 @@
 
 #include <stdint.h>
 #include "main.h"
+#include "modbus_master.h"
 
 // Modbus Function Codes
 #define MODBUS_READ_HOLDING_REG  0x03 
 #define MODBUS_WRITE_SINGLE_REG  0x06
 #define MODBUS_WRITE_MULTI_REG   0x10
+#define MODBUS_READ_WRITE_MULTI_REG 0x17
 
-// Motor Driver Registers
+// Time to wait for a slave reply before giving up (ms)
+#define MODBUS_RESPONSE_TIMEOUT_MS  50
+
+// Write batching
+#define MODBUS_BATCH_MAX         32   // Pending FC06 writes held by Modbus_BeginBatch
+#define MODBUS_MAX_WRITE_REGS    123  // FC16 quantity limit from the Modbus spec
+#define MODBUS_MAX_RW_WRITE_REGS 121  // FC23 write quantity limit from the Modbus spec
+
+// Synchronized start: 1 = stage parameters then one broadcast trigger,
+// 0 = acknowledged unicast start per axis
+#ifndef MOTOR_SYNC_BROADCAST
+#define MOTOR_SYNC_BROADCAST     1
+#endif
+
+// Motor Driver Registers (units, scaling and limits in modbus_regmap.h)
 #define REG_START_STOP           0x0001  // For start and Stop
 #define REG_DIRECTION            0x0002  // For Directon
 #define REG_SPEED                0x0003  // For Speed control
@@ -26,14 +42,33 @@
 #define REG_ACCELERATION		 0x0103  // For Acceleration
 #define REG_DECELERATION		 0x0104  // For Decelaration
 #define REG_STATUS               0x0010  // For Get Status
+#define REG_ACTUAL_SPEED         0x0011  // Measured shaft speed, read with REG_STATUS
+#define REG_LOAD                 0x0012  // Load monitor, output torque in % of rated, read with REG_STATUS
+#define REG_BAUD_RATE            0x0200  // Comm rate code, takes effect after the reply
+#define STATUS_ALARM_MASK        0x8000  // Alarm flag in REG_STATUS
+
+// Cyclic status polling, REG_STATUS, REG_ACTUAL_SPEED and REG_LOAD in one FC03
+#define MOTOR_STATUS_PERIOD_MS   20
+#define MOTOR_STATUS_REGS        3
+#define MOTOR_STATUS_DEADLINE_MS 10
 
 
 
 
-//MOTOR ID'S
+//MOTOR ID'S (default axis table, see Motor_InitAxes)
 #define DRUM_MOTOR_ID    1 // Drum Motor ID
 #define SPOOLER_MOTOR_ID 2 // Spooler Motor ID
 
+// Bus of the default spooler axis. MODBUS_BUS_AUX moves it to its own line
+// (USART2, PD5/PD6, DE on PD4) so drum and spooler traffic never queue behind
+// each other; only set it when the spooler drive is wired there.
+#ifndef MOTOR_SPOOLER_BUS
+#define MOTOR_SPOOLER_BUS MODBUS_BUS_MAIN
+#endif
+
+// Axis table capacity, statically allocated
+#define MOTOR_MAX_AXES   8
+
 //MOTOR DIRECTION
 #define FORWARD_DIRECTION 0 // CW
 #define REVERSE_DIRECTION 1 // CCW
@@ -62,10 +97,129 @@
 
 
 
+typedef enum {
+    MOTOR_ROLE_DRUM = 0,
+    MOTOR_ROLE_SPOOLER,
+    MOTOR_ROLE_AUX,
+    MOTOR_ROLE_COUNT
+} Motor_Role;
+
+// Motion recipes, see Motor_RunRecipe
+typedef enum {
+    MOTOR_RECIPE_LOW_FORWARD = 0,
+    MOTOR_RECIPE_LOW_REVERSE,
+    MOTOR_RECIPE_MID_FORWARD,
+    MOTOR_RECIPE_MID_REVERSE,
+    MOTOR_RECIPE_HIGH_FORWARD,
+    MOTOR_RECIPE_HIGH_REVERSE,
+    MOTOR_RECIPE_COUNT
+} Motor_RecipeID;
+
+// What every axis of one role runs at. Speed is the drum level in RPM; each
+// axis divides it by its speedDivisor. Torque and acceleration come from the axis.
+typedef struct {
+    uint8_t used;             // 0 leaves axes of this role alone
+    uint8_t direction;
+    uint16_t speed;
+} Motor_RecipeTarget;
+
+typedef struct {
+    Motor_RecipeTarget role[MOTOR_ROLE_COUNT];   // Indexed by Motor_Role
+} Motor_Recipe;
+
+// One drive: identity, bus, limits and per-axis scheduling state. Slave IDs
+// are unique across buses, so the slaveID-based calls below find the bus.
+typedef struct {
+    uint8_t slaveID;
+    uint8_t bus;              // MODBUS_BUS_* the drive is wired to
+    Motor_Role role;
+    uint8_t speedDivisor;     // Speed levels are the drum level divided by this
+    uint16_t torqueLimit;     // %
+    uint16_t acceleration;    // RPM/s
+    int8_t statusPoll;        // REG_STATUS/REG_ACTUAL_SPEED poll item, -1 if not polled
+} Motor_Axis;
+
+template <uint8_t N>
+struct Motor_AxisTable {
+    Motor_Axis axis[N];
+    uint8_t slaveIDs[N];      // Same order as axis[], for multi-axis triggers
+    uint8_t count;
+};
+
+template <uint8_t N>
+Motor_Axis *Motor_TableAdd(Motor_AxisTable<N> *table, uint8_t slaveID, Motor_Role role) {
+    if (table->count == N || slaveID == 0) {
+        return NULL;
+    }
+    Motor_Axis *axis = &table->axis[table->count];
+    axis->slaveID = slaveID;
+    axis->bus = MODBUS_BUS_MAIN;
+    axis->role = role;
+    axis->speedDivisor = 1;
+    axis->torqueLimit = 100;
+    axis->acceleration = 0;
+    axis->statusPoll = -1;
+    table->slaveIDs[table->count++] = slaveID;
+    return axis;
+}
+
+template <uint8_t N>
+Motor_Axis *Motor_TableFind(Motor_AxisTable<N> *table, uint8_t slaveID) {
+    for (uint8_t i = 0; i < table->count; i++) {
+        if (table->axis[i].slaveID == slaveID) {
+            return &table->axis[i];
+        }
+    }
+    return NULL;
+}
+
+typedef Motor_AxisTable<MOTOR_MAX_AXES> Motor_Axes;
+
+// Write batcher counters
+typedef struct {
+    uint32_t writes;          // FC06 writes captured while batching
+    uint32_t singleFrames;    // Isolated registers sent as FC06
+    uint32_t multiFrames;     // Contiguous runs merged into one FC16
+} Modbus_BatchStats;
+
+// Outcome of Motor_SetBusBaud
+typedef struct {
+    uint32_t baud;            // Rate the bus runs at afterwards
+    uint32_t actualBaud;      // What the USART divider really produces for it
+    int32_t errorPpm;         // actualBaud against baud
+    uint8_t rolledBack;       // Verify failed and the previous rate was restored
+} Motor_BaudResult;
+
+// Start/stop trigger counters
+typedef struct {
+    uint32_t broadcasts;      // Triggers sent as one slave 0 frame per bus
+    uint32_t sequential;      // Triggers sent as one frame per axis
+    uint32_t stagingFailures; // Triggers skipped because staging was not acknowledged
+    uint32_t lastSkewUs;      // Sequential only: first to last trigger frame leaving the wire
+    uint32_t maxSequentialSkewUs;
+} Motor_SyncStats;
+
+// Recipe executor counters
+typedef struct {
+    uint32_t runs;
+    uint32_t registers;       // Register targets the recipes asked for
+    uint32_t suppressed;      // Targets the drives already held, never sent
+    uint32_t frames;          // FC06/FC16 staging frames actually sent
+    uint8_t last;             // Motor_RecipeID of the latest run
+} Motor_RecipeStats;
+
 // FunctionS
 
 void Modbus_SendCommand(uint8_t slaveID, uint8_t functionCode, uint16_t regAddress, uint16_t value);
 uint16_t Modbus_ReadResponse(uint8_t slaveID, uint8_t functionCode, uint16_t regAddress);
+Modbus_Status Modbus_ReadRegister(uint8_t slaveID, uint16_t regAddress, uint16_t *value);
+Modbus_Status Modbus_ReadRegisters(uint8_t slaveID, uint16_t regAddress, uint16_t *values, uint8_t count);
+void Modbus_WriteMultiple(uint8_t slaveID, uint16_t startAddress, const uint16_t *values, uint16_t count);
+void Modbus_BeginBatch(void);
+void Modbus_EndBatch(void);
+uint8_t Modbus_EndBatchConfirmed(void);
+void Modbus_FlushBatch(void);
+void Modbus_GetBatchStats(Modbus_BatchStats *stats);
 void Motor_Start(uint8_t slaveID);
 void Motor_Stop(uint8_t slaveID);
 void Motor_SetDirection(uint8_t slaveID, uint8_t direction);
@@ -73,11 +227,24 @@ void Motor_SetSpeed(uint8_t slaveID, uint16_t speed);
 void Motor_SetTorqueLimit(uint8_t slaveID, uint16_t torqueLimit);
 void Motor_SetAcceleration(uint8_t slaveID, uint16_t acceleration);
 void Motor_SetDeceleration(uint8_t slaveID, uint16_t deceleration);
-void Low_Forward_Synchronize();
-void Low_Reverse_Synchronize();
-void Mid_Forward_Synchronize();
-void Mid_Reverse_Synchronize();
-void High_Forward_Synchronize();
-void High_Reverse_Synchronize();
+void Motor_SyncStart(const uint8_t *slaveIDs, uint8_t count);
+void Motor_SyncStop(const uint8_t *slaveIDs, uint8_t count);
+void Motor_InitAxes(void);
+Motor_Axis *Motor_AddAxis(uint8_t slaveID, uint8_t bus, Motor_Role role, uint8_t speedDivisor,
+                          uint16_t torqueLimit, uint16_t acceleration);
+Motor_Axis *Motor_FindAxis(uint8_t slaveID);
+Motor_Axis *Motor_FindRole(Motor_Role role);
+Motor_Axes *Motor_GetAxes(void);
+void Motor_EmergencyStop(void);
+void Motor_PollInit(void);
+uint8_t Motor_GetStatus(uint8_t slaveID, uint16_t *status);
+// Latest polled feedback; tickMs is when the reply arrived
+uint8_t Motor_GetActualSpeed(uint8_t slaveID, uint16_t *rpm, uint32_t *tickMs);
+uint8_t Motor_GetLoad(uint8_t slaveID, uint16_t *load, uint32_t *tickMs);
+Modbus_Status Motor_ReadStatus(uint8_t slaveID, uint16_t *status);
+void Motor_GetSyncStats(Motor_SyncStats *stats);
+HAL_StatusTypeDef Motor_SetBusBaud(uint8_t bus, uint32_t baud, Motor_BaudResult *result);
+void Motor_RunRecipe(Motor_RecipeID recipe);
+void Motor_GetRecipeStats(Motor_RecipeStats *stats);
 
 #endif  // MODBUS_MOTOR_H
@@ -0,0 +1,55 @@
+
+
+#ifndef MODBUS_POLL_H
+#define MODBUS_POLL_H
+
+/*
+ * modbus_poll.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdint.h>
+#include "main.h"
+#include "modbus_master.h"
+
+#define MODBUS_POLL_MAX_ITEMS    48   // Slave/register groups in the poll table
+#define MODBUS_POLL_MAX_REGS     8    // Registers read per group (one FC03)
+#define MODBUS_POLL_BATCH        4    // Reads pipelined per ModbusPoll_Service call
+#define MODBUS_POLL_MAX_LOAD     60   // % of each bus polling may claim; the rest is for setpoints
+#define MODBUS_POLL_TURNAROUND_US 1000 // Slave reply latency assumed before an RTT is measured
+
+// Latest values of one poll group. Two copies are kept and the published
+// index flips only after a copy is complete, so an ISR can read without locks.
+typedef struct {
+    uint32_t tickMs;          // HAL tick when the reply arrived
+    Modbus_Status status;
+    uint8_t count;
+    uint16_t values[MODBUS_POLL_MAX_REGS];
+} ModbusPoll_Snapshot;
+
+typedef struct {
+    uint32_t polls;
+    uint32_t errors;
+    uint32_t deadlineMisses;  // Reply later than release + deadline
+    uint32_t skipped;         // Whole periods lost because the bus was behind
+    uint32_t lastLatencyMs;   // Release to reply
+    uint32_t maxLatencyMs;
+} ModbusPoll_ItemStats;
+
+typedef void (*ModbusPoll_Callback)(uint8_t item, const ModbusPoll_Snapshot *snapshot);
+
+// Functions
+
+void ModbusPoll_Init(void);
+// Returns the item index, or -1 when the table is full or the load on that bus
+// would exceed MODBUS_POLL_MAX_LOAD
+int8_t ModbusPoll_Add(uint8_t bus, uint8_t slaveID, uint16_t regAddress, uint8_t count,
+                      uint16_t periodMs, uint16_t deadlineMs, ModbusPoll_Callback onUpdate);
+void ModbusPoll_Service(void);
+uint8_t ModbusPoll_Read(uint8_t item, ModbusPoll_Snapshot *snapshot);
+const ModbusPoll_ItemStats *ModbusPoll_GetStats(uint8_t item);
+uint32_t ModbusPoll_GetLoad(uint8_t bus);
+
+#endif  // MODBUS_POLL_H
@@ -0,0 +1,149 @@
+
+
+#ifndef MODBUS_REGMAP_H
+#define MODBUS_REGMAP_H
+
+/*
+ * modbus_regmap.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdint.h>
+#include "modbus_motor.h"
+
+typedef enum {
+    REG_UNIT_NONE = 0,
+    REG_UNIT_FLAGS,           // Bit field, see STATUS_* masks
+    REG_UNIT_CODE,            // Enumerated setting
+    REG_UNIT_RPM,
+    REG_UNIT_PERCENT,
+    REG_UNIT_RPM_PER_S
+} Motor_RegUnit;
+
+typedef enum {
+    REG_ACCESS_RO = 1,
+    REG_ACCESS_WO = 2,
+    REG_ACCESS_RW = 3
+} Motor_RegAccess;
+
+// One drive parameter. Values are in engineering units and go on the wire as
+// value * scaleNum / scaleDen. Two-word parameters are a high-word-first pair.
+typedef struct {
+    uint16_t address;
+    uint8_t words;            // 1 or 2
+    Motor_RegUnit unit;
+    uint16_t scaleNum;
+    uint16_t scaleDen;
+    int32_t min;              // Engineering units, inclusive
+    int32_t max;
+    Motor_RegAccess access;
+} Motor_RegDesc;
+
+typedef enum {
+    MOTOR_REG_START_STOP = 0,
+    MOTOR_REG_DIRECTION,
+    MOTOR_REG_SPEED,
+    MOTOR_REG_TORQUE,
+    MOTOR_REG_ACCELERATION,
+    MOTOR_REG_DECELERATION,
+    MOTOR_REG_STATUS,
+    MOTOR_REG_ACTUAL_SPEED,
+    MOTOR_REG_LOAD,
+    MOTOR_REG_BAUD_RATE,
+    MOTOR_REG_COUNT
+} Motor_Reg;
+
+// Same order as Motor_Reg
+constexpr Motor_RegDesc motorRegisters[MOTOR_REG_COUNT] = {
+    { REG_START_STOP,   1, REG_UNIT_CODE,      1, 1, 0, 1,      REG_ACCESS_RW },
+    { REG_DIRECTION,    1, REG_UNIT_CODE,      1, 1, FORWARD_DIRECTION, REVERSE_DIRECTION, REG_ACCESS_RW },
+    { REG_SPEED,        1, REG_UNIT_RPM,       1, 1, 0, 3000,   REG_ACCESS_RW },
+    { REG_TORQUE,       1, REG_UNIT_PERCENT,   1, 1, 0, 100,    REG_ACCESS_RW },
+    { REG_ACCELERATION, 1, REG_UNIT_RPM_PER_S, 1, 1, 0, 10000,  REG_ACCESS_RW },
+    { REG_DECELERATION, 1, REG_UNIT_RPM_PER_S, 1, 1, 0, 10000,  REG_ACCESS_RW },
+    { REG_STATUS,       1, REG_UNIT_FLAGS,     1, 1, 0, 0xFFFF, REG_ACCESS_RO },
+    { REG_ACTUAL_SPEED, 1, REG_UNIT_RPM,       1, 1, 0, 0xFFFF, REG_ACCESS_RO },
+    { REG_LOAD,         1, REG_UNIT_PERCENT,   1, 1, 0, 300,    REG_ACCESS_RO },
+    { REG_BAUD_RATE,    1, REG_UNIT_CODE,      1, 1, 0, 7,      REG_ACCESS_RW }
+};
+
+// Map checks, all evaluated by the compiler
+constexpr uint8_t Motor_RegMapValid(void) {
+    for (uint8_t i = 0; i < MOTOR_REG_COUNT; i++) {
+        const Motor_RegDesc &a = motorRegisters[i];
+        if ((a.words != 1 && a.words != 2) || a.scaleNum == 0 || a.scaleDen == 0 || a.min > a.max) {
+            return 0;
+        }
+        // The raw range must fit the register width
+        int64_t rawMin = (int64_t)a.min * a.scaleNum / a.scaleDen;
+        int64_t rawMax = (int64_t)a.max * a.scaleNum / a.scaleDen;
+        int64_t limit = (a.words == 1) ? 0xFFFF : 0xFFFFFFFF;
+        if (rawMin < -(limit / 2 + 1) || rawMax > limit) {
+            return 0;
+        }
+        for (uint8_t j = 0; j < i; j++) {
+            const Motor_RegDesc &b = motorRegisters[j];
+            if (a.address < b.address + b.words && b.address < a.address + a.words) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+static_assert(Motor_RegMapValid(), "drive register map: bad width, scale, limits or overlapping addresses");
+
+// Typed access to one parameter. Everything except the value itself is a
+// compile-time constant, so Encode/Decode reduce to a clamp and a multiply.
+template <Motor_Reg R>
+struct Motor_Register {
+    static_assert(R < MOTOR_REG_COUNT, "unknown drive register");
+
+    static constexpr uint16_t address = motorRegisters[R].address;
+    static constexpr uint8_t words = motorRegisters[R].words;
+    static constexpr int32_t min = motorRegisters[R].min;
+    static constexpr int32_t max = motorRegisters[R].max;
+
+    static constexpr uint8_t InRange(int32_t value) {
+        return value >= min && value <= max;
+    }
+    // Out-of-range values are clamped to the nearest limit
+    static constexpr uint32_t Encode(int32_t value) {
+        return (uint32_t)((int64_t)(value < min ? min : (value > max ? max : value))
+                          * motorRegisters[R].scaleNum / motorRegisters[R].scaleDen);
+    }
+    static constexpr int32_t Decode(uint32_t raw) {
+        return (int32_t)((int64_t)((words == 1 && min < 0) ? (int16_t)raw : (int32_t)raw)
+                         * motorRegisters[R].scaleDen / motorRegisters[R].scaleNum);
+    }
+
+    // FC06 for one word (batched and shadowed like any other write), FC16 for a pair
+    static void Write(uint8_t slaveID, int32_t value) {
+        static_assert(motorRegisters[R].access & REG_ACCESS_WO, "drive register is read-only");
+        uint32_t raw = Encode(value);
+        if (words == 1) {
+            Modbus_SendCommand(slaveID, MODBUS_WRITE_SINGLE_REG, address, (uint16_t)raw);
+        } else {
+            uint16_t pair[2] = { (uint16_t)(raw >> 16), (uint16_t)raw };
+            Modbus_WriteMultiple(slaveID, address, pair, 2);
+        }
+    }
+
+    static Modbus_Status Read(uint8_t slaveID, int32_t *value) {
+        static_assert(motorRegisters[R].access & REG_ACCESS_RO, "drive register is write-only");
+        uint16_t raw[2] = { 0, 0 };
+        Modbus_Status status = Modbus_ReadRegisters(slaveID, address, raw, words);
+        if (status == MODBUS_OK) {
+            *value = Decode((words == 1) ? raw[0] : ((uint32_t)raw[0] << 16) | raw[1]);
+        }
+        return status;
+    }
+};
+
+template <Motor_Reg R> constexpr uint16_t Motor_Register<R>::address;
+template <Motor_Reg R> constexpr uint8_t Motor_Register<R>::words;
+template <Motor_Reg R> constexpr int32_t Motor_Register<R>::min;
+template <Motor_Reg R> constexpr int32_t Motor_Register<R>::max;
+
+#endif  // MODBUS_REGMAP_H
@@ -0,0 +1,175 @@
+
+
+#ifndef MODBUS_RTU_H
+#define MODBUS_RTU_H
+
+/*
+ * modbus_rtu.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdint.h>
+#include "main.h"
+
+// Independent RTU buses, each on its own USART, DMA streams and silence timer
+#define MODBUS_BUS_COUNT         2
+#define MODBUS_BUS_MAIN          0    // USART6, TIM5
+#define MODBUS_BUS_AUX           1    // USART2, TIM2
+
+// RTU framing limits (per bus)
+#define MODBUS_MAX_FRAME         256  // Largest RTU ADU (address + PDU + CRC)
+#define MODBUS_MIN_FRAME         4    // Address + function + CRC
+#define MODBUS_RX_DMA_SIZE       256  // Circular DMA ring for RX
+#define MODBUS_RX_FRAME_SLOTS    4    // Completed frames waiting for the Modbus layer
+#define MODBUS_TX_FRAME_SLOTS    8    // Frames queued for TX DMA
+#define MODBUS_TX_ESTOP_SLOTS    2    // Extra slots only the e-stop lane may use
+
+// TX lanes, higher is more urgent. The ISR picks the most urgent queued frame
+// at every frame boundary, FIFO within a lane; an in-flight transaction
+// (request plus its reply window) is never interrupted.
+#define MODBUS_PRIO_DIAG         0    // Background diagnostics
+#define MODBUS_PRIO_POLL         1    // Cyclic status polling
+#define MODBUS_PRIO_CONTROL      2    // Setpoints and sequences
+#define MODBUS_PRIO_ESTOP        3    // Emergency stop, may be queued from an ISR
+
+// RTU inter-character (t1.5) and inter-frame (t3.5) silence
+#define MODBUS_FIXED_TIMING_BAUD 19200  // Above this rate the spec fixes the timeouts
+#define MODBUS_T15_FIXED_US      750
+#define MODBUS_T35_FIXED_US      1750
+#define MODBUS_TIMER_TICK_HZ     1000000 // Silence timers count microseconds
+
+// Runtime baud switching
+#define MODBUS_BAUD_MAX_ERROR_PPM 15000 // Largest divider error accepted, both ends share ~3 %
+
+// Event timestamps use the DWT cycle counter (wraps after ~44 s at 96 MHz)
+#define MODBUS_CYCLES_TO_US(c)   ((c) / (SystemCoreClock / 1000000U))
+#define MODBUS_US_TO_CYCLES(us)  ((us) * (SystemCoreClock / 1000000U))
+#define MODBUS_CYCLES_TO_NS(c)   ((c) * 1000U / (SystemCoreClock / 1000000U))
+
+// Receive statistics, updated from interrupt context
+typedef struct {
+    uint32_t frames;          // Frames delimited by t3.5 silence
+    uint32_t bytes;           // Bytes pulled out of the DMA ring
+    uint32_t overflows;       // Frames dropped because no slot was free
+    uint32_t oversize;        // Frames longer than MODBUS_MAX_FRAME
+    uint32_t gapErrors;       // Frames with an inter-character gap over t1.5
+    uint32_t crcErrors;       // Frames failing the streamed CRC check
+    uint32_t uartErrors;      // ORE/FE/NE/PE, reception restarted
+} ModbusRTU_RxStats;
+
+// Transmit queue statistics
+typedef struct {
+    uint32_t queued;          // Frames accepted by ModbusRTU_SendFrame
+    uint32_t sent;            // Frames whose DMA transfer completed
+    uint32_t dropped;         // Frames rejected because the queue was full
+    uint32_t cancelled;       // Queued frames withdrawn before they started
+    uint32_t startFailures;   // DMA starts HAL refused; the frame was retried after t3.5
+    uint8_t  depth;           // Frames waiting or on the wire right now
+    uint8_t  highWater;       // Largest depth seen since init
+    uint32_t preemptions;     // Frames started ahead of older queued ones
+    uint32_t estopFrames;
+    uint32_t estopLastUs;     // E-stop queued to first bit on the wire
+    uint32_t estopMaxUs;
+} ModbusRTU_TxStats;
+
+// Line utilization over a measurement window (see ModbusRTU_ResetLineStats)
+typedef struct {
+    uint32_t windowMs;        // Time since the last reset
+    uint32_t txBusyUs;        // Request bytes on the wire
+    uint32_t rxBusyUs;        // Reply bytes on the wire (bytes x character time)
+    uint32_t gapCount;        // TX starts measured
+    uint32_t gapTotalUs;      // Line free to next TX start, mandatory t3.5 included
+    uint32_t gapMaxUs;
+} ModbusRTU_LineStats;
+
+// Silence intervals derived from a bus's line settings, in microseconds
+typedef struct {
+    uint32_t baud;            // Line rate the intervals were derived from
+    uint32_t charUs;          // One character on the wire (start + data + parity + stop)
+    uint32_t t15Us;
+    uint32_t t35Us;
+} ModbusRTU_Timing;
+
+// RS-485 direction switching, see ModbusRTU_SetDriverEnable. Release times
+// exclude the fixed 12-cycle exception entry (125 ns at 96 MHz).
+typedef struct {
+    uint32_t releases;        // DE dropped on Transmission Complete
+    // BSRR write until IDR reads the pin low: the GPIO's own switching only.
+    // Interrupt latency after TC and the transceiver's driver-disable and
+    // receiver-enable times come on top and are not measured here.
+    uint32_t lastPinSwitchNs;
+    uint32_t maxPinSwitchNs;
+    uint32_t stuck;           // DE still read high after release; wiring or pin config fault
+} ModbusRTU_DeStats;
+
+// One RTU bus: USART, DMA rings, TX queue, silence timer and statistics
+typedef struct ModbusRTU_Bus ModbusRTU_Bus;
+
+// Functions
+
+ModbusRTU_Bus *ModbusRTU_Init(uint8_t index, UART_HandleTypeDef *huart, TIM_HandleTypeDef *htim);
+ModbusRTU_Bus *ModbusRTU_GetBus(uint8_t index);
+// DE (and /RE tied to it) is driven high for TX and dropped on the TC interrupt.
+// Without a pin the transceiver is expected to switch direction itself.
+void ModbusRTU_SetDriverEnable(ModbusRTU_Bus *bus, GPIO_TypeDef *port, uint16_t pin);
+void ModbusRTU_GetDeStats(ModbusRTU_Bus *bus, ModbusRTU_DeStats *stats);
+uint8_t ModbusRTU_BusIndex(const ModbusRTU_Bus *bus);
+void ModbusRTU_FlushRx(ModbusRTU_Bus *bus);
+// Only frames that passed the CRC check are ever returned
+uint16_t ModbusRTU_ReadFrame(ModbusRTU_Bus *bus, uint8_t *frame, uint16_t maxLength);
+uint16_t ModbusRTU_ReadFrameStamped(ModbusRTU_Bus *bus, uint8_t *frame, uint16_t maxLength, uint32_t *endCycles);
+uint16_t ModbusRTU_WaitFrame(ModbusRTU_Bus *bus, uint8_t *frame, uint16_t maxLength, uint32_t timeoutMs);
+const volatile ModbusRTU_RxStats *ModbusRTU_GetRxStats(ModbusRTU_Bus *bus);
+HAL_StatusTypeDef ModbusRTU_SendFrame(ModbusRTU_Bus *bus, const uint8_t *frame, uint16_t length);
+// Frames queued behind a request wait for its reply (or replyTimeoutUs)
+HAL_StatusTypeDef ModbusRTU_SendRequest(ModbusRTU_Bus *bus, const uint8_t *frame, uint16_t length,
+                                        uint32_t replyTimeoutUs, uint8_t priority, uint32_t *ticket);
+// Zero-copy TX: the caller builds the ADU in the returned slot (MODBUS_MAX_FRAME
+// bytes) and must commit it, with length 0 to give the slot back unsent
+uint8_t *ModbusRTU_ClaimFrame(ModbusRTU_Bus *bus, uint8_t priority);
+HAL_StatusTypeDef ModbusRTU_CommitFrame(ModbusRTU_Bus *bus, uint8_t *frame, uint16_t length,
+                                       uint32_t replyTimeoutUs, uint32_t *ticket);
+uint8_t ModbusRTU_TxDone(ModbusRTU_Bus *bus, uint32_t ticket, uint32_t *doneCycles, uint32_t *replyStamp);
+// Frame length plus t3.5 at the current baud, 0 once the ticket's slot is reused
+uint32_t ModbusRTU_FrameUs(ModbusRTU_Bus *bus, uint32_t ticket);
+// Withdraws a frame that has not started; returns 0 if it is on the wire or sent
+uint8_t ModbusRTU_CancelTx(ModbusRTU_Bus *bus, uint32_t ticket);
+uint16_t ModbusRTU_ReadReply(ModbusRTU_Bus *bus, uint32_t replyStamp, uint8_t *frame, uint16_t maxLength,
+                             uint32_t *endCycles);
+// Zero-copy RX: the reply stays in its RX slot until ModbusRTU_ReleaseFrame
+const uint8_t *ModbusRTU_PeekReply(ModbusRTU_Bus *bus, uint32_t replyStamp, uint16_t *length,
+                                   uint32_t *endCycles);
+void ModbusRTU_ReleaseFrame(ModbusRTU_Bus *bus);
+uint8_t ModbusRTU_ReplyCorrupt(ModbusRTU_Bus *bus, uint32_t replyStamp);
+uint8_t ModbusRTU_WaitTxIdle(ModbusRTU_Bus *bus, uint32_t timeoutMs);
+uint32_t ModbusRTU_GetTxCompleted(ModbusRTU_Bus *bus);
+uint32_t ModbusRTU_GetTxDoneCycles(ModbusRTU_Bus *bus);
+uint32_t ModbusRTU_Cycles(void);
+void ModbusRTU_DiscardRxBefore(ModbusRTU_Bus *bus, uint32_t txCompleted);
+void ModbusRTU_GetTxStats(ModbusRTU_Bus *bus, ModbusRTU_TxStats *stats);
+// Frame bytes copied by SendRequest, the ReadFrame/ReadReply family and the
+// receive ISR moving replies from the DMA ring into their RX slots
+uint32_t ModbusRTU_GetCopiedBytes(ModbusRTU_Bus *bus);
+void ModbusRTU_ResetLineStats(ModbusRTU_Bus *bus);
+void ModbusRTU_GetLineStats(ModbusRTU_Bus *bus, ModbusRTU_LineStats *stats);
+void ModbusRTU_UpdateTiming(ModbusRTU_Bus *bus);
+// Signed error of the rate the USART divider really produces, in ppm
+int32_t ModbusRTU_BaudError(ModbusRTU_Bus *bus, uint32_t baud, uint32_t *actualBaud);
+// Only between transactions; returns HAL_BUSY while frames are queued
+HAL_StatusTypeDef ModbusRTU_SetBaud(ModbusRTU_Bus *bus, uint32_t baud);
+const ModbusRTU_Timing *ModbusRTU_GetTiming(ModbusRTU_Bus *bus);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Called from each bus's USARTx_IRQHandler ahead of HAL_UART_IRQHandler
+void ModbusRTU_IRQHandler(UART_HandleTypeDef *huart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MODBUS_RTU_H
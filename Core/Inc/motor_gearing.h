@@ -0,0 +1,68 @@
+
+
+#ifndef MOTOR_GEARING_H
+#define MOTOR_GEARING_H
+
+/*
+ * motor_gearing.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdint.h>
+#include "main.h"
+#include "modbus_motor.h"
+
+// Electronic gearing: spooler speed command = measured drum speed x ratio,
+// either a fixed ratio or drum diameter / estimated spool diameter (motor_spool.h)
+#define GEARING_PERIOD_MS        40     // Control cycle, also the longest the spooler write is held
+#define GEARING_SLEW_RPM_S       600    // Largest change of the spooler command per second
+#define GEARING_STALE_MS         (3 * MOTOR_STATUS_PERIOD_MS)  // Older feedback holds the command
+#define GEARING_LOG_SIZE         64     // Cycles kept in the sync error log
+#define GEARING_SETTLE_MS        (2 * MOTOR_STATUS_PERIOD_MS)  // Spooler readings this soon after a setpoint change skip the diameter correction
+#define GEARING_SKEW_MS          (MOTOR_STATUS_PERIOD_MS / 2)  // Drum and spooler readings further apart skip it too
+
+// Bus budget: one gearing cycle (drum feedback read + spooler write) must fit
+// in this share of a 115200 baud line even if both axes shared it
+#define GEARING_BUDGET_BAUD      115200
+#define GEARING_MAX_LOAD         35     // %
+
+typedef struct {
+    uint32_t tickMs;
+    uint16_t drumRpm;         // Measured
+    uint16_t commandRpm;      // Sent to the spooler
+    uint16_t spoolerRpm;      // Measured
+    int16_t errorRpm;         // spoolerRpm - drumRpm x ratio
+    uint32_t diameterUm;      // Spool estimate, 0 at a fixed ratio
+} Gearing_LogEntry;
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t writes;          // Cycles whose command differed from the last one sent
+    uint32_t rateLimited;     // Cycles where the slew limit cut the step
+    uint32_t staleFeedback;   // Cycles held because drum feedback, or the spooler's before the first command, was missing or old
+    uint32_t overruns;        // Cycles started more than one period late
+    int16_t lastErrorRpm;
+    uint16_t maxErrorRpm;     // Largest |error| since start
+    uint32_t sumErrorRpm;     // Sum of |error|, divide by errorSamples for the mean
+    uint32_t errorSamples;
+} Gearing_Stats;
+
+// Functions
+
+// ratioNum / ratioDen spooler revolutions per drum revolution
+uint8_t Gearing_Start(uint16_t ratioNum, uint16_t ratioDen);
+// Constant line speed: the ratio follows the spool diameter from coreDiameterUm up
+uint8_t Gearing_StartSpool(uint32_t coreDiameterUm, uint16_t thicknessUm);
+void Gearing_Stop(void);
+uint8_t Gearing_Active(void);
+// Spooler command after slew limiting, before any tension trim; returns 0
+// until the spooler speed has been polled once
+uint8_t Gearing_GetCommand(uint16_t *rpm);
+void Gearing_Service(void);
+void Gearing_GetStats(Gearing_Stats *stats);
+// Copies the newest entries, up to 'max', oldest first; returns the number copied
+uint8_t Gearing_ReadLog(Gearing_LogEntry *entries, uint8_t max);
+
+#endif  // MOTOR_GEARING_H
@@ -0,0 +1,61 @@
+
+
+#ifndef MOTOR_PROFILE_H
+#define MOTOR_PROFILE_H
+
+/*
+ * motor_profile.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdint.h>
+#include "main.h"
+
+#ifdef __cplusplus
+// stm32f4xx_it.c only needs Profile_TimerTick
+#include "modbus_motor.h"
+
+// Jerk-limited speed profiles streamed to the drives from TIM6
+#define PROFILE_TICK_MS          20     // Setpoint period; one FC06 per moving axis per tick
+#define PROFILE_TIMER_HZ         10000  // TIM6 count rate after the prescaler
+#define PROFILE_JERK_RPM_S2      2000   // Jerk limit, all axes
+#define PROFILE_MAX_AXES         MOTOR_MAX_AXES
+#define PROFILE_SEGMENTS         3      // Jerk up, constant acceleration, jerk down
+
+typedef struct {
+    uint8_t slaveID;
+    uint16_t rpm;             // Speed at the end of the move
+} Profile_Target;
+
+typedef struct {
+    uint32_t moves;
+    uint32_t ticks;
+    uint32_t setpoints;       // FC06 frames queued from the timer
+    uint32_t dropped;         // Setpoints the TX queue had no room for
+    uint32_t lastTicks;       // Duration of the latest move, shared by all its axes
+    uint32_t lastTickCycles;  // Timer ISR execution time
+    uint32_t maxTickCycles;
+} Profile_Stats;
+
+// Functions
+
+// Precomputes every axis's segment table, stretched so all finish on the same
+// tick, and starts streaming. Axes that Gearing drives must be released first.
+uint8_t Profile_Move(const Profile_Target *targets, uint8_t count);
+void Profile_Abort(void);
+uint8_t Profile_Busy(void);
+void Profile_GetStats(Profile_Stats *stats);
+
+extern "C" {
+#endif
+
+// Called from TIM6_IRQHandler after HAL_TIM_IRQHandler
+void Profile_TimerTick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MOTOR_PROFILE_H
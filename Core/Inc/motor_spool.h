@@ -0,0 +1,56 @@
+
+
+#ifndef MOTOR_SPOOL_H
+#define MOTOR_SPOOL_H
+
+/*
+ * motor_spool.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdint.h>
+
+// Constant linear speed spooling. The drum is a capstan of fixed diameter, so
+// it sets the line speed; the spooler has to turn at
+// drumRpm x drumDiameter / spoolDiameter as the spool fills.
+#define SPOOL_DRUM_DIAMETER_UM   100000   // Capstan, 100 mm
+#define SPOOL_MAX_DIAMETER_UM    1200000  // Flange; the estimate never goes past it
+#define SPOOL_THICKNESS_UM       200      // Material, one layer per spool revolution
+#define SPOOL_MEASURE_SHIFT      4        // Each ratio measurement moves the estimate 1/2^n of the way
+#define SPOOL_MEASURE_MIN_RPM    20       // Slower than this the RPM resolution swamps the ratio
+
+// Diameter estimate, updated once per gearing cycle in constant time:
+// - prediction: every spooler revolution adds two material thicknesses
+// - correction: drumDiameter x drumRpm / spoolerRpm, the diameter the measured
+//   speeds imply. This assumes the line, not a speed command derived from the
+//   estimate, sets the spooler's speed: it only tells something new while the
+//   spooler falls short of its command (torque limited), and under plain speed
+//   control it just confirms the prediction. A tension trim moves the spooler
+//   for reasons unrelated to the diameter, and readings taken before the
+//   spooler settles carry the poll lag, so the caller must clear 'measured' in
+//   both cases (Gearing_Settled does).
+// Either source can be switched off: thickness 0 leaves the measurement alone,
+// measured 0 in every Spool_Update leaves the prediction alone.
+typedef struct {
+    uint32_t samples;
+    uint32_t corrections;     // Samples whose ratio measurement was used
+    uint32_t clamped;         // Samples where the estimate hit the core or the flange
+    uint32_t milliRevs;       // Spooler revolutions since Spool_Start, x1000
+    uint32_t diameterUm;      // Current estimate
+    uint32_t lastMeasuredUm;  // Latest ratio measurement, 0 if none yet
+} Spool_Stats;
+
+// Functions
+
+void Spool_Start(uint32_t coreDiameterUm, uint16_t thicknessUm);
+// dtMs since the previous sample; spoolerRpm is the measured speed when
+// 'measured' is set, the commanded one otherwise
+void Spool_Update(uint32_t dtMs, uint16_t drumRpm, uint16_t spoolerRpm, uint8_t measured);
+uint32_t Spool_GetDiameter(void);
+// Spooler speed that matches the drum's line speed at the current diameter
+uint16_t Spool_Target(uint16_t drumRpm);
+void Spool_GetStats(Spool_Stats *stats);
+
+#endif  // MOTOR_SPOOL_H
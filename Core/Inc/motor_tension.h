@@ -0,0 +1,70 @@
+
+
+#ifndef MOTOR_TENSION_H
+#define MOTOR_TENSION_H
+
+/*
+ * motor_tension.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdint.h>
+#include "main.h"
+
+#ifdef __cplusplus
+// stm32f4xx_it.c only needs Tension_TimerTick
+#include "modbus_motor.h"
+
+// Winding tension loop: PI on the spooler's load monitor, trimming the
+// spooler speed command on top of the gearing command, run from TIM7
+#define TENSION_PERIOD_MS        20     // Loop period; no faster than the status poll that feeds it
+#define TENSION_TIMER_HZ         10000  // TIM7 count rate after the prescaler
+#define TENSION_SETPOINT_LOAD    30     // Default spooler load to hold, % of rated torque
+#define TENSION_KP_Q8            512    // Proportional gain, RPM per % of load error, Q8
+#define TENSION_KI_Q8            64     // Integral gain, RPM per % of load error per cycle, Q8
+#define TENSION_MAX_TRIM_RPM     60     // Trim limit either way; the integrator is held inside it
+#define TENSION_STALE_MS         (3 * MOTOR_STATUS_PERIOD_MS)  // Older load readings hold the trim
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t writes;          // Speed setpoints queued
+    uint32_t dropped;         // Setpoints the TX queue had no room for
+    uint32_t staleFeedback;   // Cycles held because the load reading was missing or old
+    uint32_t noBase;          // Cycles not sent because the untrimmed spooler speed was not known yet
+    uint32_t saturated;       // Cycles whose output hit TENSION_MAX_TRIM_RPM
+    int16_t lastTrimRpm;
+    int16_t lastErrorLoad;    // Setpoint - measured, %
+    uint32_t lastExecCycles;  // Timer ISR execution time
+    uint32_t maxExecCycles;
+    uint32_t lastPeriodCycles;  // Entry to entry
+    uint32_t lastJitterCycles;  // |period - nominal|
+    uint32_t maxJitterCycles;
+    uint64_t sumJitterCycles;   // Divide by jitterSamples for the mean
+    uint32_t jitterSamples;
+} Tension_Stats;
+
+// Functions
+
+// load in % of rated spooler torque, below the spooler's torque limit. The
+// base speed is the gearing command when gearing runs, the spooler's
+// first polled speed after start otherwise; nothing is sent before it is known.
+uint8_t Tension_Start(uint16_t load);
+void Tension_Stop(void);
+uint8_t Tension_Active(void);
+// RPM currently added to the spooler's base speed, 0 while stopped
+int16_t Tension_GetTrim(void);
+void Tension_GetStats(Tension_Stats *stats);
+
+extern "C" {
+#endif
+
+// Called from TIM7_IRQHandler after HAL_TIM_IRQHandler
+void Tension_TimerTick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MOTOR_TENSION_H
@@ -0,0 +1,85 @@
+/*
+* modbus_crc.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+#include "modbus_crc.h"
+
+// Generated by the compiler; unused tables are dropped by --gc-sections
+static constexpr ModbusCRC_Table<16> crcNibble = ModbusCRC_MakeTable<16>();
+static constexpr ModbusCRC_Table<256> crcTable = ModbusCRC_MakeTable<256>();
+static constexpr ModbusCRC_Table<4 * 256> crcSlice4 = ModbusCRC_MakeSlice4();
+
+static_assert(crcTable.v[1] == 0xC0C1 && crcTable.v[255] == 0x4040, "CRC table generation");
+static_assert(crcNibble.v[1] == 0xCC01 && crcNibble.v[15] == 0x4400, "CRC nibble table generation");
+
+
+uint16_t ModbusCRC_UpdateBitwise(uint16_t crc, const uint8_t *buffer, uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        crc ^= buffer[i];
+        for (uint8_t j = 0; j < 8; j++) {
+            if (crc & 0x0001)
+                crc = (crc >> 1) ^ MODBUS_CRC_POLY;
+            else
+                crc >>= 1;
+        }
+    }
+    return crc;
+}
+
+uint16_t ModbusCRC_UpdateNibble(uint16_t crc, const uint8_t *buffer, uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        crc ^= buffer[i];
+        crc = (crc >> 4) ^ crcNibble.v[crc & 0x0F];
+        crc = (crc >> 4) ^ crcNibble.v[crc & 0x0F];
+    }
+    return crc;
+}
+
+uint16_t ModbusCRC_UpdateTable(uint16_t crc, const uint8_t *buffer, uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        crc = (crc >> 8) ^ crcTable.v[(crc ^ buffer[i]) & 0xFF];
+    }
+    return crc;
+}
+
+uint16_t ModbusCRC_UpdateSlice4(uint16_t crc, const uint8_t *buffer, uint16_t length) {
+    const uint16_t *t0 = &crcSlice4.v[0];
+    const uint16_t *t1 = &crcSlice4.v[256];
+    const uint16_t *t2 = &crcSlice4.v[512];
+    const uint16_t *t3 = &crcSlice4.v[768];
+
+    // The 16-bit CRC only overlaps the first two bytes of each group
+    while (length >= 4) {
+        crc = t3[(crc ^ buffer[0]) & 0xFF]
+            ^ t2[((crc >> 8) ^ buffer[1]) & 0xFF]
+            ^ t1[buffer[2]]
+            ^ t0[buffer[3]];
+        buffer += 4;
+        length -= 4;
+    }
+    while (length--) {
+        crc = (crc >> 8) ^ t0[(crc ^ *buffer++) & 0xFF];
+    }
+    return crc;
+}
+
+uint16_t ModbusCRC_Update(uint16_t crc, const uint8_t *buffer, uint16_t length) {
+#if MODBUS_CRC_BACKEND == MODBUS_CRC_BITWISE
+    return ModbusCRC_UpdateBitwise(crc, buffer, length);
+#elif MODBUS_CRC_BACKEND == MODBUS_CRC_NIBBLE
+    return ModbusCRC_UpdateNibble(crc, buffer, length);
+#elif MODBUS_CRC_BACKEND == MODBUS_CRC_TABLE
+    return ModbusCRC_UpdateTable(crc, buffer, length);
+#elif MODBUS_CRC_BACKEND == MODBUS_CRC_SLICE4
+    return ModbusCRC_UpdateSlice4(crc, buffer, length);
+#else
+#error "Unknown MODBUS_CRC_BACKEND"
+#endif
+}
+
+uint16_t Modbus_CalculateCRC(const uint8_t *buffer, uint16_t length) {
+    return ModbusCRC_Update(MODBUS_CRC_INIT, buffer, length);
+}
@@ -0,0 +1,677 @@
+/*
+* modbus_master.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+#include <string.h>
+#include "modbus_master.h"
+#include "modbus_motor.h"
+#include "modbus_rtu.h"
+#include "modbus_crc.h"
+#include "modbus_frame.h"
+
+typedef struct {
+    uint8_t bus;
+    uint8_t slaveID;          // 0 marks a free entry
+    uint16_t regAddress;
+    uint16_t value;
+} Modbus_ShadowEntry;
+
+static Modbus_SlaveStats slaveStats[MODBUS_BUS_COUNT][MODBUS_MAX_SLAVE_ID + 1];
+static Modbus_ShadowEntry shadow[MODBUS_SHADOW_ENTRIES];
+static uint8_t shadowVictim;
+static Modbus_ShadowStats shadowStats;
+static volatile uint8_t shadowStale[MODBUS_BUS_COUNT];   // Set by Modbus_QueueEmergency, may run in an ISR
+static volatile uint8_t streamHeld[MODBUS_BUS_COUNT];    // Modbus_QueueStream refuses while set
+
+
+Modbus_Status Modbus_ParseResponse(const uint8_t *frame, uint16_t length, uint8_t slaveID,
+                                   uint8_t functionCode, Modbus_Response *result) {
+    // CRC has already been checked by the RTU receiver while the bytes arrived,
+    // so only the PDU is validated here. Lengths below include the 2 CRC bytes.
+    result->count = 0;
+    result->exceptionCode = 0;
+    result->regAddress = 0;
+    result->value = 0;
+
+    if (length < MODBUS_MIN_FRAME) {
+        return result->status = MODBUS_ERR_LENGTH;
+    }
+
+    result->slaveID = frame[0];
+    result->functionCode = frame[1];
+
+    if (frame[0] != slaveID) {
+        return result->status = MODBUS_ERR_SLAVE;
+    }
+
+    if (frame[1] == (functionCode | MODBUS_EXCEPTION_FLAG)) {
+        if (length != 5) {
+            return result->status = MODBUS_ERR_LENGTH;
+        }
+        result->exceptionCode = frame[2];
+        return result->status = MODBUS_ERR_EXCEPTION;
+    }
+
+    if (frame[1] != functionCode) {
+        return result->status = MODBUS_ERR_FUNCTION;
+    }
+
+    switch (functionCode) {
+    case MODBUS_READ_HOLDING_REG:
+        return result->status = Modbus_Frame<MODBUS_READ_HOLDING_REG>::Parse(frame, length, result);
+    case MODBUS_WRITE_SINGLE_REG:
+        return result->status = Modbus_Frame<MODBUS_WRITE_SINGLE_REG>::Parse(frame, length, result);
+    case MODBUS_WRITE_MULTI_REG:
+        return result->status = Modbus_Frame<MODBUS_WRITE_MULTI_REG>::Parse(frame, length, result);
+    case MODBUS_READ_WRITE_MULTI_REG:
+        return result->status = Modbus_Frame<MODBUS_READ_WRITE_MULTI_REG>::Parse(frame, length, result);
+    default:
+        return result->status = MODBUS_ERR_FUNCTION;
+    }
+}
+
+Modbus_Status Modbus_ReceiveResponse(uint8_t bus, uint8_t slaveID, uint8_t functionCode,
+                                     uint32_t timeoutMs, Modbus_Response *result) {
+    uint8_t frame[MODBUS_MAX_FRAME];
+    ModbusRTU_Bus *rtu = ModbusRTU_GetBus(bus);
+    uint32_t start = HAL_GetTick();
+
+    memset(result, 0, sizeof(*result));
+    if (rtu == NULL) {
+        return result->status = MODBUS_ERR_TIMEOUT;
+    }
+    const volatile ModbusRTU_RxStats *rxStats = ModbusRTU_GetRxStats(rtu);
+
+    // Replies to earlier queued writes are not ours
+    if (!ModbusRTU_WaitTxIdle(rtu, timeoutMs)) {
+        return result->status = MODBUS_ERR_TIMEOUT;
+    }
+    ModbusRTU_DiscardRxBefore(rtu, ModbusRTU_GetTxCompleted(rtu));
+
+    // A corrupted reply ends the wait at once instead of running out the timeout
+    uint32_t crcErrors = rxStats->crcErrors;
+    do {
+        uint16_t length = ModbusRTU_ReadFrame(rtu, frame, sizeof(frame));
+        if (length != 0) {
+            return Modbus_ParseResponse(frame, length, slaveID, functionCode, result);
+        }
+        if (rxStats->crcErrors != crcErrors) {
+            return result->status = MODBUS_ERR_CRC;
+        }
+    } while ((HAL_GetTick() - start) < timeoutMs);
+
+    return result->status = MODBUS_ERR_TIMEOUT;
+}
+
+uint16_t Modbus_BuildRequest(const Modbus_Request *request, uint8_t *frame) {
+    // 'frame' is normally a claimed TX slot, see Modbus_Submit
+    switch (request->functionCode) {
+    case MODBUS_READ_HOLDING_REG:
+        return Modbus_Frame<MODBUS_READ_HOLDING_REG>::Write(frame, request);
+    case MODBUS_WRITE_SINGLE_REG:
+        return Modbus_Frame<MODBUS_WRITE_SINGLE_REG>::Write(frame, request);
+    case MODBUS_WRITE_MULTI_REG:
+        return Modbus_Frame<MODBUS_WRITE_MULTI_REG>::Write(frame, request);
+    case MODBUS_READ_WRITE_MULTI_REG:
+        return Modbus_Frame<MODBUS_READ_WRITE_MULTI_REG>::Write(frame, request);
+    default:
+        // Other function codes with the fixed address + value layout
+        return ModbusFrame_Seal(frame, ModbusFrame_WriteHeader(frame, request));
+    }
+}
+
+static void Modbus_ShadowForgetRange(uint8_t bus, uint8_t slaveID, uint16_t first, uint32_t count);
+
+static Modbus_ShadowEntry *Modbus_ShadowFind(uint8_t bus, uint8_t slaveID, uint16_t regAddress) {
+    for (uint8_t b = 0; b < MODBUS_BUS_COUNT; b++) {
+        if (shadowStale[b]) {
+            // An emergency frame went out behind our back; nothing is known any more
+            shadowStale[b] = 0;
+            Modbus_ShadowForgetRange(b, MODBUS_BROADCAST_ID, 0, 0x10000);
+        }
+    }
+    for (uint8_t i = 0; i < MODBUS_SHADOW_ENTRIES; i++) {
+        if (shadow[i].slaveID == slaveID && shadow[i].bus == bus && shadow[i].regAddress == regAddress) {
+            return &shadow[i];
+        }
+    }
+    return NULL;
+}
+
+static void Modbus_ShadowStore(uint8_t bus, uint8_t slaveID, uint16_t regAddress, uint16_t value, uint8_t insert) {
+    Modbus_ShadowEntry *entry = Modbus_ShadowFind(bus, slaveID, regAddress);
+
+    if (entry == NULL) {
+        if (!insert) {
+            return;
+        }
+        for (uint8_t i = 0; i < MODBUS_SHADOW_ENTRIES && entry == NULL; i++) {
+            if (shadow[i].slaveID == 0) {
+                entry = &shadow[i];
+            }
+        }
+        if (entry == NULL) {
+            entry = &shadow[shadowVictim];
+            shadowVictim = (shadowVictim + 1) % MODBUS_SHADOW_ENTRIES;
+        }
+        entry->bus = bus;
+        entry->slaveID = slaveID;
+        entry->regAddress = regAddress;
+    }
+    entry->value = value;
+    shadowStats.updates++;
+}
+
+// Drops entries of one slave (or every slave on the bus for a broadcast) in [first, first + count)
+static void Modbus_ShadowForgetRange(uint8_t bus, uint8_t slaveID, uint16_t first, uint32_t count) {
+    for (uint8_t i = 0; i < MODBUS_SHADOW_ENTRIES; i++) {
+        if (shadow[i].slaveID != 0 && shadow[i].bus == bus
+            && (slaveID == MODBUS_BROADCAST_ID || shadow[i].slaveID == slaveID)
+            && (uint16_t)(shadow[i].regAddress - first) < count) {
+            shadow[i].slaveID = 0;
+            shadowStats.invalidations++;
+        }
+    }
+}
+
+static void Modbus_ShadowForget(const Modbus_Request *request) {
+    // The drive may now hold a value nobody acknowledged
+    if (request->functionCode == MODBUS_WRITE_SINGLE_REG) {
+        Modbus_ShadowForgetRange(request->bus, request->slaveID, request->regAddress, 1);
+    } else if (request->functionCode == MODBUS_WRITE_MULTI_REG) {
+        Modbus_ShadowForgetRange(request->bus, request->slaveID, request->regAddress, request->value);
+    } else if (request->functionCode == MODBUS_READ_WRITE_MULTI_REG) {
+        Modbus_ShadowForgetRange(request->bus, request->slaveID, request->writeAddress, request->writeCount);
+    }
+}
+
+static void Modbus_ShadowUpdate(const Modbus_Request *request, const Modbus_Response *result) {
+    if (result->status != MODBUS_OK) {
+        // Timeouts and exceptions leave the drive state unknown
+        Modbus_ShadowInvalidate(request->bus, request->slaveID);
+        return;
+    }
+
+    switch (request->functionCode) {
+    case MODBUS_WRITE_SINGLE_REG:
+        Modbus_ShadowStore(request->bus, request->slaveID, request->regAddress, request->value, 1);
+        break;
+    case MODBUS_WRITE_MULTI_REG:
+        for (uint16_t i = 0; i < request->value; i++) {
+            Modbus_ShadowStore(request->bus, request->slaveID, request->regAddress + i, request->values[i], 1);
+        }
+        break;
+    case MODBUS_READ_WRITE_MULTI_REG:
+        // The write lands before the read, so the read data wins on overlap
+        for (uint16_t i = 0; i < request->writeCount; i++) {
+            Modbus_ShadowStore(request->bus, request->slaveID, request->writeAddress + i, request->values[i], 1);
+        }
+        // fall through
+    case MODBUS_READ_HOLDING_REG:
+        // Reads refresh tracked registers but do not pull new ones in
+        for (uint8_t i = 0; i < result->count; i++) {
+            Modbus_ShadowStore(request->bus, request->slaveID, request->regAddress + i, result->registers[i], 0);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+uint8_t Modbus_ShadowMatch(uint8_t bus, uint8_t slaveID, uint16_t regAddress, uint16_t value) {
+    const Modbus_ShadowEntry *entry = (slaveID != MODBUS_BROADCAST_ID)
+                                      ? Modbus_ShadowFind(bus, slaveID, regAddress) : NULL;
+
+    if (entry != NULL && entry->value == value) {
+        shadowStats.hits++;
+        return 1;
+    }
+    shadowStats.misses++;
+    return 0;
+}
+
+void Modbus_ShadowInvalidate(uint8_t bus, uint8_t slaveID) {
+    Modbus_ShadowForgetRange(bus, slaveID, 0, 0x10000);
+}
+
+void Modbus_GetShadowStats(Modbus_ShadowStats *stats) {
+    *stats = shadowStats;
+}
+
+static uint32_t Modbus_ReplyTimeoutUs(const Modbus_Request *request) {
+    if (request->slaveID > MODBUS_MAX_SLAVE_ID || request->bus >= MODBUS_BUS_COUNT) {
+        return 0;
+    }
+    if (request->slaveID == MODBUS_BROADCAST_ID) {
+        // Nobody answers, but nothing may follow before the turnaround delay
+        return MODBUS_BROADCAST_TURNAROUND_US;
+    }
+    const Modbus_SlaveStats *stats = &slaveStats[request->bus][request->slaveID];
+    return (stats->rtoUs != 0) ? stats->rtoUs : MODBUS_RTO_INITIAL_US;
+}
+
+static HAL_StatusTypeDef Modbus_Submit(const Modbus_Request *request, uint32_t timeoutUs, uint32_t *ticket) {
+    ModbusRTU_Bus *bus = ModbusRTU_GetBus(request->bus);
+
+    if (bus == NULL) {
+        return HAL_ERROR;
+    }
+    // Built straight into the bus's TX slot; anything queued behind it waits for the reply
+    uint8_t *frame = ModbusRTU_ClaimFrame(bus, request->priority);
+    if (frame == NULL) {
+        return HAL_BUSY;
+    }
+    return ModbusRTU_CommitFrame(bus, frame, Modbus_BuildRequest(request, frame), timeoutUs, ticket);
+}
+
+HAL_StatusTypeDef Modbus_QueueEmergency(const Modbus_Request *request) {
+    ModbusRTU_Bus *bus = ModbusRTU_GetBus(request->bus);
+
+    // Safe from interrupt context: no shadow or slave statistics are touched
+    // here, the bus's shadow is dropped on the next lookup instead
+    if (bus == NULL) {
+        return HAL_ERROR;
+    }
+    uint8_t *frame = ModbusRTU_ClaimFrame(bus, MODBUS_PRIO_ESTOP);
+    if (frame == NULL) {
+        return HAL_BUSY;
+    }
+    uint16_t length = Modbus_BuildRequest(request, frame);
+    if (length != 0) {
+        shadowStale[request->bus] = 1;
+    }
+    return ModbusRTU_CommitFrame(bus, frame, length, Modbus_ReplyTimeoutUs(request), NULL);
+}
+
+HAL_StatusTypeDef Modbus_QueueStream(const Modbus_Request *request) {
+    // Claim and commit run with interrupts masked, so a timer ISR may feed
+    // setpoints while the main loop queues its own requests
+    if (request->bus < MODBUS_BUS_COUNT && streamHeld[request->bus]) {
+        return HAL_BUSY;
+    }
+    return Modbus_Submit(request, Modbus_ReplyTimeoutUs(request), NULL);
+}
+
+void Modbus_HoldStreams(uint8_t bus, uint8_t hold) {
+    if (bus < MODBUS_BUS_COUNT) {
+        streamHeld[bus] = hold;
+    }
+}
+
+HAL_StatusTypeDef Modbus_QueueRequest(const Modbus_Request *request) {
+    Modbus_ShadowForget(request);
+    return Modbus_Submit(request, Modbus_ReplyTimeoutUs(request), NULL);
+}
+
+static void Modbus_SampleRtt(Modbus_SlaveStats *stats, uint32_t rttUs) {
+    // RFC 6298: alpha = 1/8, beta = 1/4, RTO = SRTT + max(G, 4 * RTTVAR)
+    if (stats->samples == 0) {
+        stats->srttUs = rttUs;
+        stats->rttvarUs = rttUs / 2;
+    } else {
+        uint32_t delta = (stats->srttUs > rttUs) ? stats->srttUs - rttUs : rttUs - stats->srttUs;
+        stats->rttvarUs = (3 * stats->rttvarUs + delta) / 4;
+        stats->srttUs = (7 * stats->srttUs + rttUs) / 8;
+    }
+    stats->lastRttUs = rttUs;
+    stats->samples++;
+
+    uint32_t var = 4 * stats->rttvarUs;
+    uint32_t rto = stats->srttUs + ((var > MODBUS_RTO_GRANULARITY_US) ? var : MODBUS_RTO_GRANULARITY_US);
+    if (rto < MODBUS_RTO_MIN_US) {
+        rto = MODBUS_RTO_MIN_US;
+    } else if (rto > MODBUS_RTO_MAX_US) {
+        rto = MODBUS_RTO_MAX_US;
+    }
+    stats->rtoUs = rto;
+}
+
+// Outcome of putting a request on our own TX queue. A full queue means nothing
+// reached the slave, so it never counts against the slave's statistics.
+static Modbus_Status Modbus_QueueStatus(HAL_StatusTypeDef sent) {
+    if (sent == HAL_OK) {
+        return MODBUS_OK;
+    }
+    return (sent == HAL_BUSY) ? MODBUS_ERR_QUEUE_FULL : MODBUS_ERR_LENGTH;
+}
+
+static Modbus_Status Modbus_CheckEcho(const Modbus_Request *request, const Modbus_Response *result) {
+    switch (request->functionCode) {
+    case MODBUS_READ_HOLDING_REG:
+    case MODBUS_READ_WRITE_MULTI_REG:
+        return (result->count == request->value) ? MODBUS_OK : MODBUS_ERR_LENGTH;
+    case MODBUS_WRITE_SINGLE_REG:
+    case MODBUS_WRITE_MULTI_REG:
+        return (result->regAddress == request->regAddress && result->value == request->value)
+               ? MODBUS_OK : MODBUS_ERR_ECHO;
+    default:
+        return MODBUS_OK;
+    }
+}
+
+// How long a queued request may wait for its final stop bit: the pipeline
+// ahead of it, then its own frame. One extra ms for the tick granularity.
+static uint32_t Modbus_TxWaitMs(ModbusRTU_Bus *bus, uint32_t ticket) {
+    return (MODBUS_TX_WAIT_US + ModbusRTU_FrameUs(bus, ticket) + 999U) / 1000U + 1U;
+}
+
+static Modbus_Status Modbus_Collect(const Modbus_Request *request, uint32_t ticket, uint32_t timeoutUs,
+                                    Modbus_Response *result, uint32_t *rttUs) {
+    ModbusRTU_Bus *bus = ModbusRTU_GetBus(request->bus);
+    uint32_t timeoutCycles = MODBUS_US_TO_CYCLES(timeoutUs);
+    uint32_t start = HAL_GetTick();
+    uint32_t waitMs = Modbus_TxWaitMs(bus, ticket);
+    uint32_t txDone;
+    uint32_t replyStamp;
+
+    // The timeout runs from the request's final stop bit, however long it queued
+    while (!ModbusRTU_TxDone(bus, ticket, &txDone, &replyStamp)) {
+        if ((HAL_GetTick() - start) >= waitMs && ModbusRTU_CancelTx(bus, ticket)) {
+            // Withdrawn, so it can never go out late and have its reply taken
+            // for a later request's; once on the wire it runs to the end
+            return result->status = MODBUS_ERR_TIMEOUT;
+        }
+    }
+
+    while ((ModbusRTU_Cycles() - txDone) < timeoutCycles) {
+        uint32_t endCycles;
+        uint16_t length;
+        const uint8_t *frame = ModbusRTU_PeekReply(bus, replyStamp, &length, &endCycles);
+        if (frame != NULL) {
+            // Parsed where the receiver assembled it, then the slot is handed back
+            *rttUs = MODBUS_CYCLES_TO_US(endCycles - txDone);
+            Modbus_ParseResponse(frame, length, request->slaveID, request->functionCode, result);
+            ModbusRTU_ReleaseFrame(bus);
+            if (result->status != MODBUS_OK) {
+                return result->status;
+            }
+            return result->status = Modbus_CheckEcho(request, result);
+        }
+        if (ModbusRTU_ReplyCorrupt(bus, replyStamp)) {
+            return result->status = MODBUS_ERR_CRC;
+        }
+    }
+    return result->status = MODBUS_ERR_TIMEOUT;
+}
+
+// Returns 1 when the transaction is settled, 0 when the attempt may be retried
+static uint8_t Modbus_Account(Modbus_SlaveStats *stats, uint8_t attempt, Modbus_Status status,
+                              const Modbus_Response *result, uint32_t rttUs) {
+    if (status == MODBUS_ERR_TIMEOUT) {
+        stats->timeouts++;
+        return 0;
+    }
+    if (status == MODBUS_ERR_CRC
+        || (status == MODBUS_ERR_EXCEPTION && result->exceptionCode == MODBUS_EX_DEVICE_BUSY)) {
+        return 0;
+    }
+
+    // Karn: only first attempts give unambiguous RTT samples
+    if (attempt == 0 && status != MODBUS_ERR_SLAVE) {
+        Modbus_SampleRtt(stats, rttUs);
+    }
+    stats->consecutiveFailures = 0;
+    return 1;
+}
+
+static uint8_t Modbus_AttemptLimit(const Modbus_SlaveStats *stats) {
+    // A slave that keeps failing gets a single attempt until it answers again
+    return (stats->consecutiveFailures >= MODBUS_OFFLINE_AFTER) ? 1 : 1 + MODBUS_MAX_RETRIES;
+}
+
+static Modbus_Status Modbus_Attempts(const Modbus_Request *request, Modbus_Response *result,
+                                     Modbus_SlaveStats *stats, uint8_t attempt, uint32_t timeoutUs) {
+    uint8_t attempts = Modbus_AttemptLimit(stats);
+
+    for (; attempt < attempts; attempt++) {
+        if (attempt != 0) {
+            stats->retries++;
+            timeoutUs = (timeoutUs * 2 < MODBUS_RTO_MAX_US) ? timeoutUs * 2 : MODBUS_RTO_MAX_US;
+        }
+
+        uint32_t ticket;
+        uint32_t rttUs = 0;
+        Modbus_Status status;
+        HAL_StatusTypeDef sent = Modbus_Submit(request, timeoutUs, &ticket);
+        if (sent != HAL_OK) {
+            // Retry budget and failure count stay as they are
+            return result->status = Modbus_QueueStatus(sent);
+        }
+        status = Modbus_Collect(request, ticket, timeoutUs, result, &rttUs);
+
+        if (Modbus_Account(stats, attempt, status, result, rttUs)) {
+            return status;
+        }
+    }
+
+    stats->failures++;
+    if (stats->consecutiveFailures < 0xFF) {
+        stats->consecutiveFailures++;
+    }
+    return result->status;
+}
+
+Modbus_Status Modbus_Transaction(const Modbus_Request *request, Modbus_Response *result) {
+    memset(result, 0, sizeof(*result));
+
+    if (request->slaveID == MODBUS_BROADCAST_ID) {
+        // Broadcasts are never answered
+        return result->status = Modbus_QueueStatus(Modbus_QueueRequest(request));
+    }
+    if (request->slaveID > MODBUS_MAX_SLAVE_ID || request->bus >= MODBUS_BUS_COUNT) {
+        return result->status = MODBUS_ERR_SLAVE;
+    }
+
+    Modbus_SlaveStats *stats = &slaveStats[request->bus][request->slaveID];
+    stats->transactions++;
+    Modbus_Attempts(request, result, stats, 0, Modbus_ReplyTimeoutUs(request));
+    Modbus_ShadowUpdate(request, result);
+    return result->status;
+}
+
+uint8_t Modbus_TransactionBatch(const Modbus_Request *requests, Modbus_Response *results, uint8_t count) {
+    uint32_t ticket[MODBUS_PIPELINE_DEPTH];
+    uint32_t timeoutUs[MODBUS_PIPELINE_DEPTH];
+    HAL_StatusTypeDef sent[MODBUS_PIPELINE_DEPTH];
+    uint8_t submitted = 0;
+    uint8_t ok = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        const Modbus_Request *request = &requests[i];
+        Modbus_Response *result = &results[i];
+
+        // Keep up to MODBUS_PIPELINE_DEPTH frames queued ahead. On one bus the
+        // RTU layer releases each at t3.5 after the previous reply; frames for
+        // different buses are on their own lines at the same time.
+        while (submitted < count && submitted < i + MODBUS_PIPELINE_DEPTH) {
+            uint8_t k = submitted % MODBUS_PIPELINE_DEPTH;
+            timeoutUs[k] = Modbus_ReplyTimeoutUs(&requests[submitted]);
+            Modbus_ShadowForget(&requests[submitted]);
+            sent[k] = Modbus_Submit(&requests[submitted], timeoutUs[k], &ticket[k]);
+            submitted++;
+        }
+
+        uint8_t k = i % MODBUS_PIPELINE_DEPTH;
+        memset(result, 0, sizeof(*result));
+        if (request->slaveID == MODBUS_BROADCAST_ID) {
+            result->status = Modbus_QueueStatus(sent[k]);
+        } else if (request->slaveID > MODBUS_MAX_SLAVE_ID || request->bus >= MODBUS_BUS_COUNT) {
+            result->status = MODBUS_ERR_SLAVE;
+        } else if (sent[k] != HAL_OK) {
+            result->status = Modbus_QueueStatus(sent[k]);
+        } else {
+            Modbus_SlaveStats *stats = &slaveStats[request->bus][request->slaveID];
+            uint32_t rttUs = 0;
+            Modbus_Status status = Modbus_Collect(request, ticket[k], timeoutUs[k], result, &rttUs);
+
+            stats->transactions++;
+            if (!Modbus_Account(stats, 0, status, result, rttUs)) {
+                // Retries leave the pipeline and queue behind the frames already sent
+                Modbus_Attempts(request, result, stats, 1, timeoutUs[k]);
+            }
+            Modbus_ShadowUpdate(request, result);
+        }
+
+        if (result->status == MODBUS_OK) {
+            ok++;
+        }
+    }
+    return ok;
+}
+
+uint8_t Modbus_Scan(uint8_t bus, uint16_t regAddress, Modbus_ScanResult *result) {
+    uint8_t candidate[(MODBUS_MAX_SLAVE_ID + 8) / 8] = {0};
+    Modbus_Request probe[2];
+    Modbus_Response response;
+    uint32_t start = HAL_GetTick();
+    uint32_t ticket = 0;
+    HAL_StatusTypeDef sent;
+
+    memset(result, 0, sizeof(*result));
+    if (ModbusRTU_GetBus(bus) == NULL) {
+        return 0;
+    }
+    for (uint8_t k = 0; k < 2; k++) {
+        probe[k].functionCode = MODBUS_READ_HOLDING_REG;
+        probe[k].regAddress = regAddress;
+        probe[k].value = 1;
+        probe[k].values = NULL;
+        probe[k].priority = MODBUS_PRIO_DIAG;
+        probe[k].bus = bus;
+    }
+
+    // First pass: one pipelined probe per ID with a short reply window, so an
+    // empty address costs about one request plus the window instead of a full
+    // response timeout. A slow drive's reply may land in a later probe's
+    // window, so each intact reply is credited to the address it carries, not
+    // to the ID being probed. Garbled frames name nobody reliably and are
+    // skipped; the second pass confirms every candidate anyway.
+    probe[1].slaveID = 1;
+    sent = Modbus_Submit(&probe[1], MODBUS_SCAN_FIRST_US, &ticket);
+    for (uint16_t id = 1; id <= MODBUS_MAX_SLAVE_ID; id++) {
+        uint32_t nextTicket = 0;
+        HAL_StatusTypeDef nextSent = HAL_ERROR;
+        uint32_t rttUs;
+
+        probe[0] = probe[1];
+        if (id < MODBUS_MAX_SLAVE_ID) {
+            probe[1].slaveID = (uint8_t)(id + 1);
+            nextSent = Modbus_Submit(&probe[1], MODBUS_SCAN_FIRST_US, &nextTicket);
+        }
+
+        if (sent == HAL_OK) {
+            memset(&response, 0, sizeof(response));
+            Modbus_Status status = Modbus_Collect(&probe[0], ticket, MODBUS_SCAN_FIRST_US, &response, &rttUs);
+            uint8_t seen = response.slaveID;
+            if (status != MODBUS_ERR_TIMEOUT && status != MODBUS_ERR_CRC
+                && seen != MODBUS_BROADCAST_ID && seen <= MODBUS_MAX_SLAVE_ID) {
+                candidate[seen / 8] |= (uint8_t)(1 << (seen % 8));
+            }
+        }
+        ticket = nextTicket;
+        sent = nextSent;
+    }
+
+    // Second pass: confirm candidates with a normal timeout and measure them
+    for (uint16_t id = 1; id <= MODBUS_MAX_SLAVE_ID; id++) {
+        if (!(candidate[id / 8] & (1 << (id % 8)))) {
+            continue;
+        }
+        result->candidates++;
+
+        uint32_t rttUs = 0;
+        Modbus_Status status = MODBUS_ERR_TIMEOUT;
+        probe[0].slaveID = (uint8_t)id;
+        if (Modbus_Submit(&probe[0], MODBUS_SCAN_CONFIRM_US, &ticket) == HAL_OK) {
+            status = Modbus_Collect(&probe[0], ticket, MODBUS_SCAN_CONFIRM_US, &response, &rttUs);
+        }
+
+        // An exception still proves a drive is there
+        if ((status == MODBUS_OK || status == MODBUS_ERR_EXCEPTION) && result->count < MODBUS_SCAN_MAX_FOUND) {
+            Modbus_SlaveStats *stats = &slaveStats[bus][id];
+            Modbus_SampleRtt(stats, rttUs);
+            stats->consecutiveFailures = 0;
+
+            result->slaveID[result->count] = (uint8_t)id;
+            result->rttUs[result->count] = rttUs;
+            result->count++;
+        }
+    }
+
+    result->durationMs = HAL_GetTick() - start;
+    return result->count;
+}
+
+static Modbus_Status Modbus_StagedRead(const Modbus_Request *request, uint32_t timeoutUs, Modbus_Response *result) {
+    // The path requests took before frames were built in place: stack buffer,
+    // copy into the TX slot, reply copied out of the RX slot and parsed there
+    uint8_t frame[MODBUS_MAX_FRAME];
+    ModbusRTU_Bus *bus = ModbusRTU_GetBus(request->bus);
+    uint16_t length = Modbus_BuildRequest(request, frame);
+    uint32_t timeoutCycles = MODBUS_US_TO_CYCLES(timeoutUs);
+    uint32_t start = HAL_GetTick();
+    uint32_t ticket;
+    uint32_t txDone;
+    uint32_t replyStamp;
+
+    HAL_StatusTypeDef sent = ModbusRTU_SendRequest(bus, frame, length, timeoutUs, request->priority, &ticket);
+    if (sent != HAL_OK) {
+        return result->status = Modbus_QueueStatus(sent);
+    }
+    uint32_t waitMs = Modbus_TxWaitMs(bus, ticket);
+    while (!ModbusRTU_TxDone(bus, ticket, &txDone, &replyStamp)) {
+        if ((HAL_GetTick() - start) >= waitMs && ModbusRTU_CancelTx(bus, ticket)) {
+            return result->status = MODBUS_ERR_TIMEOUT;
+        }
+    }
+    while ((ModbusRTU_Cycles() - txDone) < timeoutCycles) {
+        length = ModbusRTU_ReadReply(bus, replyStamp, frame, sizeof(frame), NULL);
+        if (length != 0) {
+            return Modbus_ParseResponse(frame, length, request->slaveID, request->functionCode, result);
+        }
+    }
+    return result->status = MODBUS_ERR_TIMEOUT;
+}
+
+void Modbus_CopyBenchmark(uint8_t bus, uint8_t slaveID, uint16_t regAddress, uint8_t count,
+                          Modbus_CopyBenchResult *result) {
+    static Modbus_Response response;
+    Modbus_Request request = { slaveID, MODBUS_READ_HOLDING_REG, regAddress, count, NULL, MODBUS_PRIO_DIAG, bus,
+                               0, 0 };
+    ModbusRTU_Bus *rtu = ModbusRTU_GetBus(bus);
+    uint32_t before;
+    uint32_t rttUs;
+    uint32_t ticket;
+
+    memset(result, 0, sizeof(*result));
+    result->stagedStatus = result->zeroCopyStatus = MODBUS_ERR_SLAVE;
+    if (rtu == NULL || slaveID == MODBUS_BROADCAST_ID || slaveID > MODBUS_MAX_SLAVE_ID) {
+        return;
+    }
+
+    memset(&response, 0, sizeof(response));
+    before = ModbusRTU_GetCopiedBytes(rtu);
+    result->stagedStatus = Modbus_StagedRead(&request, MODBUS_RTO_INITIAL_US, &response);
+    result->stagedBytes = ModbusRTU_GetCopiedBytes(rtu) - before;
+
+    memset(&response, 0, sizeof(response));
+    before = ModbusRTU_GetCopiedBytes(rtu);
+    HAL_StatusTypeDef sent = Modbus_Submit(&request, MODBUS_RTO_INITIAL_US, &ticket);
+    result->zeroCopyStatus = (sent == HAL_OK)
+                             ? Modbus_Collect(&request, ticket, MODBUS_RTO_INITIAL_US, &response, &rttUs)
+                             : Modbus_QueueStatus(sent);
+    result->zeroCopyBytes = ModbusRTU_GetCopiedBytes(rtu) - before;
+}
+
+const Modbus_SlaveStats *Modbus_GetSlaveStats(uint8_t bus, uint8_t slaveID) {
+    return (bus < MODBUS_BUS_COUNT && slaveID <= MODBUS_MAX_SLAVE_ID) ? &slaveStats[bus][slaveID] : NULL;
+}
+
+void Modbus_ResetSlaveStats(uint8_t bus, uint8_t slaveID) {
+    if (bus < MODBUS_BUS_COUNT && slaveID <= MODBUS_MAX_SLAVE_ID) {
+        memset(&slaveStats[bus][slaveID], 0, sizeof(slaveStats[bus][slaveID]));
+    }
+}
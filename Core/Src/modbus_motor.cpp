@@ -5,160 +5,661 @@
 *      Author: arunp
 */
 
+#include <string.h>
 #include "modbus_motor.h"
+#include "modbus_rtu.h"
+#include "modbus_crc.h"
+#include "modbus_master.h"
+#include "modbus_poll.h"
+#include "modbus_regmap.h"
 
-extern UART_HandleTypeDef huart6;
+typedef struct {
+    uint8_t bus;
+    uint8_t slaveID;
+    uint16_t regAddress;
+    uint16_t value;
+} Modbus_PendingWrite;
 
+// Writes collected between Modbus_BeginBatch and Modbus_EndBatch
+static Modbus_PendingWrite batch[MODBUS_BATCH_MAX];
+static uint8_t batchCount;
+static uint8_t batchDepth;
+static Modbus_BatchStats batchStats;
+static uint8_t batchConfirm;
+static uint8_t batchFailures;
 
-uint16_t Modbus_CalculateCRC(uint8_t *buffer, uint16_t length) {
-    uint16_t crc = 0xFFFF;
-    for (uint16_t i = 0; i < length; i++) {
-        crc ^= buffer[i];
-        for (uint8_t j = 0; j < 8; j++) {
-            if (crc & 0x0001)
-                crc = (crc >> 1) ^ 0xA001;
-            else
-                crc >>= 1;
+static Motor_SyncStats syncStats;
+static Motor_Axes axes;
+
+// REG_BAUD_RATE codes understood by the drives
+typedef struct {
+    uint32_t baud;
+    uint16_t code;
+} Motor_BaudCode;
+
+// Drum and spooler run every recipe together; the spooler follows at its divisor
+#define MOTOR_RECIPE(direction, speed) \
+    { { { 1, (direction), (speed) }, { 1, (direction), (speed) }, { 0, 0, 0 } } }
+
+// Same order as Motor_RecipeID
+static constexpr Motor_Recipe recipes[MOTOR_RECIPE_COUNT] = {
+    MOTOR_RECIPE(FORWARD_DIRECTION, M1_SPEED_LOW),
+    MOTOR_RECIPE(REVERSE_DIRECTION, M1_SPEED_LOW),
+    MOTOR_RECIPE(FORWARD_DIRECTION, M1_SPEED_MID),
+    MOTOR_RECIPE(REVERSE_DIRECTION, M1_SPEED_MID),
+    MOTOR_RECIPE(FORWARD_DIRECTION, M1_SPEED_HIGH),
+    MOTOR_RECIPE(REVERSE_DIRECTION, M1_SPEED_HIGH)
+};
+
+static constexpr uint8_t Motor_RecipesValid(void) {
+    for (uint8_t r = 0; r < MOTOR_RECIPE_COUNT; r++) {
+        for (uint8_t k = 0; k < MOTOR_ROLE_COUNT; k++) {
+            const Motor_RecipeTarget &target = recipes[r].role[k];
+            if (target.used && (!Motor_Register<MOTOR_REG_SPEED>::InRange(target.speed)
+                                || !Motor_Register<MOTOR_REG_DIRECTION>::InRange(target.direction))) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+static_assert(Motor_RecipesValid(), "motion recipe outside the drive register limits");
+
+static Motor_RecipeStats recipeStats;
+
+static const Motor_BaudCode baudCodes[] = {
+    { 9600, 0 }, { 19200, 1 }, { 38400, 2 }, { 57600, 3 },
+    { 115200, 4 }, { 230400, 5 }, { 460800, 6 }, { 921600, 7 }
+};
+
+
+static uint8_t Motor_BusOf(uint8_t slaveID) {
+    const Motor_Axis *axis = Motor_TableFind(&axes, slaveID);
+    return (axis != NULL) ? axis->bus : MODBUS_BUS_MAIN;
+}
+
+static void Modbus_SendRequest(uint8_t slaveID, uint8_t functionCode, uint16_t regAddress, uint16_t value) {
+    Modbus_Request request = { slaveID, functionCode, regAddress, value, NULL, MODBUS_PRIO_CONTROL,
+                               Motor_BusOf(slaveID), 0, 0 };
+    Modbus_QueueRequest(&request);
+}
+
+static void Modbus_BatchSend(const Modbus_Request *requests, uint8_t count) {
+    if (!batchConfirm) {
+        for (uint8_t i = 0; i < count; i++) {
+            Modbus_QueueRequest(&requests[i]);
+        }
+        return;
+    }
+
+    // Pipelined, so confirming N axes costs N round trips back to back on
+    // each bus, with the buses running side by side
+    Modbus_Response responses[MODBUS_PIPELINE_DEPTH];
+    for (uint8_t i = 0; i < count; i += MODBUS_PIPELINE_DEPTH) {
+        uint8_t n = (count - i < MODBUS_PIPELINE_DEPTH) ? count - i : MODBUS_PIPELINE_DEPTH;
+        batchFailures += n - Modbus_TransactionBatch(&requests[i], responses, n);
+    }
+}
+
+// A stop always goes out, whatever the shadow says: the drive may have been
+// started from its panel or an IO input, or our own start may have been lost
+static uint8_t Modbus_Suppressible(uint16_t regAddress, uint16_t value) {
+    return !(regAddress == REG_START_STOP && value == 0);
+}
+
+static void Modbus_BatchWrite(uint8_t slaveID, uint16_t regAddress, uint16_t value) {
+    uint8_t bus = Motor_BusOf(slaveID);
+
+    batchStats.writes++;
+
+    // A later write to the same register replaces the earlier one
+    for (uint8_t i = 0; i < batchCount; i++) {
+        if (batch[i].slaveID == slaveID && batch[i].regAddress == regAddress) {
+            batch[i].value = value;
+            return;
         }
     }
-    return crc;
+
+    // Nothing pending for this register, so the shadow is current
+    if (Modbus_Suppressible(regAddress, value) && Modbus_ShadowMatch(bus, slaveID, regAddress, value)) {
+        return;
+    }
+
+    if (batchCount == MODBUS_BATCH_MAX) {
+        Modbus_FlushBatch();
+    }
+    batch[batchCount].bus = bus;
+    batch[batchCount].slaveID = slaveID;
+    batch[batchCount].regAddress = regAddress;
+    batch[batchCount].value = value;
+    batchCount++;
 }
 
 void Modbus_SendCommand(uint8_t slaveID, uint8_t functionCode, uint16_t regAddress, uint16_t value) {
-    uint8_t request[8];
-    request[0] = slaveID;
-    request[1] = functionCode;
-    request[2] = (regAddress >> 8) & 0xFF;
-    request[3] = regAddress & 0xFF;
-    request[4] = (value >> 8) & 0xFF;
-    request[5] = value & 0xFF;
-    uint16_t crc = Modbus_CalculateCRC(request, 6);
-    request[6] = crc & 0xFF;
-    request[7] = (crc >> 8) & 0xFF;
-    
-    // Use UART1 handle
-    HAL_UART_Transmit(&huart6, request, 8, HAL_MAX_DELAY);
+    if (batchDepth != 0 && functionCode == MODBUS_WRITE_SINGLE_REG) {
+        Modbus_BatchWrite(slaveID, regAddress, value);
+        return;
+    }
+
+    if (functionCode == MODBUS_WRITE_SINGLE_REG && Modbus_Suppressible(regAddress, value)
+        && Modbus_ShadowMatch(Motor_BusOf(slaveID), slaveID, regAddress, value)) {
+        return;
+    }
+    Modbus_SendRequest(slaveID, functionCode, regAddress, value);
+}
+
+void Modbus_WriteMultiple(uint8_t slaveID, uint16_t startAddress, const uint16_t *values, uint16_t count) {
+    Modbus_Request request = { slaveID, MODBUS_WRITE_MULTI_REG, startAddress, count, values, MODBUS_PRIO_CONTROL,
+                               Motor_BusOf(slaveID), 0, 0 };
+    Modbus_QueueRequest(&request);
+}
+
+void Modbus_BeginBatch(void) {
+    batchDepth++;
+}
+
+void Modbus_EndBatch(void) {
+    if (batchDepth != 0 && --batchDepth == 0) {
+        Modbus_FlushBatch();
+    }
+}
+
+uint8_t Modbus_EndBatchConfirmed(void) {
+    // Same as Modbus_EndBatch, but each frame waits for its reply.
+    // Returns 1 when every write of the outermost batch was acknowledged.
+    batchConfirm = 1;
+    batchFailures = 0;
+    Modbus_EndBatch();
+    batchConfirm = 0;
+    return batchFailures == 0;
+}
+
+void Modbus_FlushBatch(void) {
+    Modbus_PendingWrite run[MODBUS_BATCH_MAX];
+    Modbus_Request requests[MODBUS_BATCH_MAX];
+    uint16_t values[MODBUS_BATCH_MAX];
+    uint8_t done[MODBUS_BATCH_MAX] = {0};
+    uint8_t frames = 0;
+    uint8_t used = 0;
+
+    // Slaves go out in the order they were first written to; within a slave
+    // registers go out in address order so contiguous ones can share a frame
+    for (uint8_t first = 0; first < batchCount; first++) {
+        if (done[first]) {
+            continue;
+        }
+
+        uint8_t slaveID = batch[first].slaveID;
+        uint8_t n = 0;
+        for (uint8_t i = first; i < batchCount; i++) {
+            if (!done[i] && batch[i].slaveID == slaveID) {
+                uint8_t j = n++;
+                while (j > 0 && run[j - 1].regAddress > batch[i].regAddress) {
+                    run[j] = run[j - 1];
+                    j--;
+                }
+                run[j] = batch[i];
+                done[i] = 1;
+            }
+        }
+
+        for (uint8_t start = 0; start < n; ) {
+            uint8_t end = start + 1;
+            while (end < n && run[end].regAddress == run[end - 1].regAddress + 1
+                   && end - start < MODBUS_MAX_WRITE_REGS) {
+                end++;
+            }
+
+            Modbus_Request *request = &requests[frames++];
+            request->slaveID = slaveID;
+            request->functionCode = MODBUS_WRITE_SINGLE_REG;
+            request->regAddress = run[start].regAddress;
+            request->value = run[start].value;
+            request->values = NULL;
+            request->priority = MODBUS_PRIO_CONTROL;
+            request->bus = batch[first].bus;
+            if (end - start == 1) {
+                batchStats.singleFrames++;
+            } else {
+                // Each FC16 keeps its own stretch of values until everything is sent
+                batchStats.multiFrames++;
+                request->functionCode = MODBUS_WRITE_MULTI_REG;
+                request->value = end - start;
+                request->values = &values[used];
+                for (uint8_t k = start; k < end; k++) {
+                    values[used++] = run[k].value;
+                }
+            }
+            start = end;
+        }
+    }
+
+    batchCount = 0;
+    Modbus_BatchSend(requests, frames);
+}
+
+void Modbus_GetBatchStats(Modbus_BatchStats *stats) {
+    *stats = batchStats;
 }
 
 uint16_t Modbus_ReadResponse(uint8_t slaveID, uint8_t functionCode, uint16_t regAddress) {
-    uint8_t response[8];
+    Modbus_Response response;
     
-    // Use UART1 handle
-    HAL_UART_Receive(&huart6, response, 8, HAL_MAX_DELAY);
+    // Any error (timeout, exception, wrong slave, bad echo) reads as 0
+    if (Modbus_ReceiveResponse(Motor_BusOf(slaveID), slaveID, functionCode, MODBUS_RESPONSE_TIMEOUT_MS,
+                               &response) != MODBUS_OK) {
+        return 0;
+    }
     
-    return (response[3] << 8) | response[4]; // Example response parsing
+    if (functionCode == MODBUS_READ_HOLDING_REG) {
+        return (response.count != 0) ? response.registers[0] : 0;
+    }
+    return (response.regAddress == regAddress) ? response.value : 0;
+}
+
+Modbus_Status Modbus_ReadRegister(uint8_t slaveID, uint16_t regAddress, uint16_t *value) {
+    return Modbus_ReadRegisters(slaveID, regAddress, value, 1);
 }
 
+Modbus_Status Modbus_ReadRegisters(uint8_t slaveID, uint16_t regAddress, uint16_t *values, uint8_t count) {
+    Modbus_Request request = { slaveID, MODBUS_READ_HOLDING_REG, regAddress, count, NULL, MODBUS_PRIO_POLL,
+                               Motor_BusOf(slaveID), 0, 0 };
+    Modbus_Response response;
+
+    // Adaptive timeout and retries come from the transaction engine
+    Modbus_Status status = Modbus_Transaction(&request, &response);
+    if (status == MODBUS_OK) {
+        memcpy(values, response.registers, count * sizeof(uint16_t));
+    }
+    return status;
+}
+
+// Setpoints are clamped to the register map limits before they go out
 void Motor_Start(uint8_t slaveID) {
-    Modbus_SendCommand(slaveID, MODBUS_WRITE_SINGLE_REG, REG_START_STOP, 1);
+    Motor_Register<MOTOR_REG_START_STOP>::Write(slaveID, 1);
 }
 
 void Motor_Stop(uint8_t slaveID) {
-    Modbus_SendCommand(slaveID, MODBUS_WRITE_SINGLE_REG, REG_START_STOP, 0);
+    // Exempt from the shadow, see Modbus_Suppressible
+    Motor_Register<MOTOR_REG_START_STOP>::Write(slaveID, 0);
 }
 
 void Motor_SetDirection(uint8_t slaveID, uint8_t direction) {
-    Modbus_SendCommand(slaveID, MODBUS_WRITE_SINGLE_REG, REG_DIRECTION, direction);
+    Motor_Register<MOTOR_REG_DIRECTION>::Write(slaveID, direction);
 }
 
 void Motor_SetSpeed(uint8_t slaveID, uint16_t speed) {
-    Modbus_SendCommand(slaveID, MODBUS_WRITE_SINGLE_REG, REG_SPEED, speed);
+    Motor_Register<MOTOR_REG_SPEED>::Write(slaveID, speed);
 }
 
 void Motor_SetTorqueLimit(uint8_t slaveID, uint16_t torqueLimit) {
     // Torque limit value is in percentage (0–100%)
-    Modbus_SendCommand(slaveID, MODBUS_WRITE_SINGLE_REG, REG_TORQUE, torqueLimit);
+    Motor_Register<MOTOR_REG_TORQUE>::Write(slaveID, torqueLimit);
 }
 
 void Motor_SetAcceleration(uint8_t slaveID, uint16_t acceleration) {
     // Set acceleration in RPM/s
-    Modbus_SendCommand(slaveID, MODBUS_WRITE_SINGLE_REG, REG_ACCELERATION, acceleration);
+    Motor_Register<MOTOR_REG_ACCELERATION>::Write(slaveID, acceleration);
 }
 
 void Motor_SetDeceleration(uint8_t slaveID, uint16_t deceleration) {
     // Set deceleration in RPM/s
-    Modbus_SendCommand(slaveID, MODBUS_WRITE_SINGLE_REG, REG_DECELERATION, deceleration);
+    Motor_Register<MOTOR_REG_DECELERATION>::Write(slaveID, deceleration);
 }
 
+static uint8_t Motor_TriggerBroadcasts(uint8_t count) {
+    return MOTOR_SYNC_BROADCAST && count > 1;
+}
 
-void Low_Forward_Synchronize() {
-    
-    Motor_Start(DRUM_MOTOR_ID);
-    //Motor_Start(SPOOLER_MOTOR_ID);
-    
-    Motor_SetDirection(DRUM_MOTOR_ID,FORWARD_DIRECTION);
-    //Motor_SetDirection(SPOOLER_MOTOR_ID, FORWARD_DIRECTION);
-    Motor_SetSpeed(DRUM_MOTOR_ID,M1_SPEED_LOW);
-    Motor_SetAcceleration(DRUM_MOTOR_ID,M1_ACCELERATION);
-    Motor_SetTorqueLimit(DRUM_MOTOR_ID,M1_TORQUE_LIMIT);
-        //Motor_SetAcceleration(SPOOLER_MOTOR_ID,M2_SPEED_LOW);
-    
+static void Motor_Trigger(const uint8_t *slaveIDs, uint8_t count, uint16_t run) {
+    Modbus_Response response;
+
+    if (Motor_TriggerBroadcasts(count)) {
+        // Every drive on a bus decodes the same frame, so there is no master
+        // side skew to measure; what remains is each drive's own
+        // frame-to-action latency. The RTU queue holds each bus for the
+        // broadcast turnaround delay before anything else goes out.
+        uint8_t used[MODBUS_BUS_COUNT] = {0};
+        for (uint8_t i = 0; i < count; i++) {
+            used[Motor_BusOf(slaveIDs[i])] = 1;
+        }
+        for (uint8_t b = 0; b < MODBUS_BUS_COUNT; b++) {
+            Modbus_Request request = { MODBUS_BROADCAST_ID, MODBUS_WRITE_SINGLE_REG, REG_START_STOP, run, NULL,
+                                       MODBUS_PRIO_CONTROL, b, 0, 0 };
+            if (used[b]) {
+                Modbus_Transaction(&request, &response);
+            }
+        }
+        syncStats.broadcasts++;
+        return;
+    }
+
+    // One acknowledged frame per axis; the skew is the spacing of their stop bits
+    uint32_t first = 0;
+    uint32_t last = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        Modbus_Request request = { slaveIDs[i], MODBUS_WRITE_SINGLE_REG, REG_START_STOP, run, NULL,
+                                   MODBUS_PRIO_CONTROL, Motor_BusOf(slaveIDs[i]), 0, 0 };
+        ModbusRTU_Bus *bus = ModbusRTU_GetBus(request.bus);
+        Modbus_Transaction(&request, &response);
+        if (bus != NULL) {
+            last = ModbusRTU_GetTxDoneCycles(bus);
+        }
+        if (i == 0) {
+            first = last;
+        }
+    }
+    syncStats.sequential++;
+    syncStats.lastSkewUs = MODBUS_CYCLES_TO_US(last - first);
+    if (syncStats.lastSkewUs > syncStats.maxSequentialSkewUs) {
+        syncStats.maxSequentialSkewUs = syncStats.lastSkewUs;
+    }
 }
 
+void Motor_SyncStart(const uint8_t *slaveIDs, uint8_t count) {
+    // Closes the caller's staging batch; the trigger only goes out once
+    // every axis has acknowledged its parameters
+    if (!Modbus_EndBatchConfirmed()) {
+        syncStats.stagingFailures++;
+        return;
+    }
+
+    // Axes already acknowledged as running need no new trigger. Only unicast
+    // starts are acknowledged: a broadcast drops the shadow of its whole bus,
+    // so a broadcast group start always goes out. Stops are never suppressed.
+    if (!Motor_TriggerBroadcasts(count)) {
+        uint8_t running = 0;
+        while (running < count
+               && Modbus_ShadowMatch(Motor_BusOf(slaveIDs[running]), slaveIDs[running], REG_START_STOP, 1)) {
+            running++;
+        }
+        if (running == count) {
+            return;
+        }
+    }
+    Motor_Trigger(slaveIDs, count, 1);
+}
 
-void Low_Reverse_Synchronize() {
-    
-    Motor_Start(DRUM_MOTOR_ID);
-    Motor_Start(SPOOLER_MOTOR_ID);
-    
-    Motor_SetDirection(DRUM_MOTOR_ID, REVERSE_DIRECTION);
-    Motor_SetDirection(SPOOLER_MOTOR_ID, REVERSE_DIRECTION);
-    
-    Motor_SetAcceleration(DRUM_MOTOR_ID,M1_SPEED_LOW);
-    Motor_SetAcceleration(SPOOLER_MOTOR_ID,M2_SPEED_LOW);
+void Motor_SyncStop(const uint8_t *slaveIDs, uint8_t count) {
+    // The trigger is a direct transaction, so the shadow never holds it back
+    Motor_Trigger(slaveIDs, count, 0);
 }
 
+Modbus_Status Motor_ReadStatus(uint8_t slaveID, uint16_t *status) {
+    Modbus_Status result = Modbus_ReadRegister(slaveID, REG_STATUS, status);
 
-void Mid_Forward_Synchronize() {
-    Motor_Start(DRUM_MOTOR_ID);
-    Motor_Start(SPOOLER_MOTOR_ID);
-    
-    Motor_SetDirection(DRUM_MOTOR_ID, FORWARD_DIRECTION);
-    Motor_SetDirection(SPOOLER_MOTOR_ID, FORWARD_DIRECTION);
-    
-    Motor_SetAcceleration(DRUM_MOTOR_ID,M1_SPEED_MID);
-    Motor_SetAcceleration(SPOOLER_MOTOR_ID,M2_SPEED_MID);
+    // An alarm may have reset drive parameters behind our back
+    if (result == MODBUS_OK && (*status & STATUS_ALARM_MASK)) {
+        Modbus_ShadowInvalidate(Motor_BusOf(slaveID), slaveID);
+    }
+    return result;
 }
 
+void Motor_EmergencyStop(void) {
+    // One broadcast per bus in the reserved e-stop lane; each goes out as soon
+    // as the transaction currently on its bus finishes. Callable from an ISR.
+    for (uint8_t b = 0; b < MODBUS_BUS_COUNT; b++) {
+        Modbus_Request request = { MODBUS_BROADCAST_ID, MODBUS_WRITE_SINGLE_REG, REG_START_STOP, 0, NULL,
+                                   MODBUS_PRIO_ESTOP, b, 0, 0 };
+        Modbus_QueueEmergency(&request);
+    }
+}
 
-void Mid_Reverse_Synchronize() {
-    
-    Motor_Start(DRUM_MOTOR_ID);
-    Motor_Start(SPOOLER_MOTOR_ID);
-    
-    Motor_SetDirection(DRUM_MOTOR_ID, REVERSE_DIRECTION);
-    Motor_SetDirection(SPOOLER_MOTOR_ID, REVERSE_DIRECTION);
-    
-    
-    Motor_SetAcceleration(DRUM_MOTOR_ID,M1_SPEED_MID);
-    Motor_SetAcceleration(SPOOLER_MOTOR_ID,M2_SPEED_MID);
+void Motor_InitAxes(void) {
+    axes.count = 0;
+    Motor_AddAxis(DRUM_MOTOR_ID, MODBUS_BUS_MAIN, MOTOR_ROLE_DRUM, 1, M1_TORQUE_LIMIT, M1_ACCELERATION);
+    Motor_AddAxis(SPOOLER_MOTOR_ID, MOTOR_SPOOLER_BUS, MOTOR_ROLE_SPOOLER, M1_SPEED_LOW / M2_SPEED_LOW,
+                  M2_TORQUE_LIMIT, M2_ACCELERATION);
 }
 
+Motor_Axis *Motor_AddAxis(uint8_t slaveID, uint8_t bus, Motor_Role role, uint8_t speedDivisor,
+                          uint16_t torqueLimit, uint16_t acceleration) {
+    if (Motor_TableFind(&axes, slaveID) != NULL || bus >= MODBUS_BUS_COUNT) {
+        return NULL;
+    }
+    Motor_Axis *axis = Motor_TableAdd(&axes, slaveID, role);
+    if (axis != NULL) {
+        axis->bus = bus;
+        axis->speedDivisor = (speedDivisor != 0) ? speedDivisor : 1;
+        axis->torqueLimit = torqueLimit;
+        axis->acceleration = acceleration;
+    }
+    return axis;
+}
 
-void High_Forward_Synchronize() {
-    
-    Motor_Start(DRUM_MOTOR_ID);
-    Motor_Start(SPOOLER_MOTOR_ID);
-    
-    Motor_SetDirection(DRUM_MOTOR_ID, FORWARD_DIRECTION);
-    Motor_SetDirection(SPOOLER_MOTOR_ID, FORWARD_DIRECTION);
-    
-    
-    Motor_SetAcceleration(DRUM_MOTOR_ID,M1_SPEED_HIGH);
-    Motor_SetAcceleration(SPOOLER_MOTOR_ID,M2_SPEED_HIGH);
+Motor_Axis *Motor_FindAxis(uint8_t slaveID) {
+    return Motor_TableFind(&axes, slaveID);
 }
 
+Motor_Axis *Motor_FindRole(Motor_Role role) {
+    for (uint8_t i = 0; i < axes.count; i++) {
+        if (axes.axis[i].role == role) {
+            return &axes.axis[i];
+        }
+    }
+    return NULL;
+}
 
-void High_Reverse_Synchronize() {
-    
-    Motor_Start(DRUM_MOTOR_ID);
-    Motor_Start(SPOOLER_MOTOR_ID);
-    
-    Motor_SetDirection(DRUM_MOTOR_ID, REVERSE_DIRECTION);
-    Motor_SetDirection(SPOOLER_MOTOR_ID,REVERSE_DIRECTION);
-    
-    
-    Motor_SetAcceleration(DRUM_MOTOR_ID,M1_SPEED_HIGH);
-    Motor_SetAcceleration(SPOOLER_MOTOR_ID,M2_SPEED_HIGH);
+Motor_Axes *Motor_GetAxes(void) {
+    return &axes;
+}
+
+static void Motor_StatusUpdated(uint8_t item, const ModbusPoll_Snapshot *snapshot) {
+    // An alarm may have reset drive parameters behind our back
+    if (snapshot->status == MODBUS_OK && (snapshot->values[0] & STATUS_ALARM_MASK)) {
+        for (uint8_t i = 0; i < axes.count; i++) {
+            if (axes.axis[i].statusPoll == (int8_t)item) {
+                Modbus_ShadowInvalidate(axes.axis[i].bus, axes.axis[i].slaveID);
+            }
+        }
+    }
+}
+
+void Motor_PollInit(void) {
+    for (uint8_t i = 0; i < axes.count; i++) {
+        axes.axis[i].statusPoll = ModbusPoll_Add(axes.axis[i].bus, axes.axis[i].slaveID, REG_STATUS, MOTOR_STATUS_REGS,
+                                                 MOTOR_STATUS_PERIOD_MS, MOTOR_STATUS_DEADLINE_MS,
+                                                 Motor_StatusUpdated);
+    }
+}
+
+uint8_t Motor_GetStatus(uint8_t slaveID, uint16_t *status) {
+    const Motor_Axis *axis = Motor_FindAxis(slaveID);
+    ModbusPoll_Snapshot snapshot;
+
+    if (axis == NULL || axis->statusPoll < 0 || !ModbusPoll_Read(axis->statusPoll, &snapshot)) {
+        return 0;
+    }
+    *status = snapshot.values[0];
+    return 1;
+}
+
+uint8_t Motor_GetActualSpeed(uint8_t slaveID, uint16_t *rpm, uint32_t *tickMs) {
+    const Motor_Axis *axis = Motor_FindAxis(slaveID);
+    ModbusPoll_Snapshot snapshot;
+
+    if (axis == NULL || axis->statusPoll < 0 || !ModbusPoll_Read(axis->statusPoll, &snapshot)
+        || snapshot.count < MOTOR_STATUS_REGS) {
+        return 0;
+    }
+    *rpm = (uint16_t)Motor_Register<MOTOR_REG_ACTUAL_SPEED>::Decode(snapshot.values[REG_ACTUAL_SPEED - REG_STATUS]);
+    *tickMs = snapshot.tickMs;
+    return 1;
+}
+
+uint8_t Motor_GetLoad(uint8_t slaveID, uint16_t *load, uint32_t *tickMs) {
+    const Motor_Axis *axis = Motor_FindAxis(slaveID);
+    ModbusPoll_Snapshot snapshot;
+
+    if (axis == NULL || axis->statusPoll < 0 || !ModbusPoll_Read(axis->statusPoll, &snapshot)
+        || snapshot.count < MOTOR_STATUS_REGS) {
+        return 0;
+    }
+    *load = (uint16_t)Motor_Register<MOTOR_REG_LOAD>::Decode(snapshot.values[REG_LOAD - REG_STATUS]);
+    *tickMs = snapshot.tickMs;
+    return 1;
+}
+
+void Motor_GetSyncStats(Motor_SyncStats *stats) {
+    *stats = syncStats;
+}
+
+static int32_t Motor_BaudCodeOf(uint32_t baud) {
+    for (uint8_t i = 0; i < sizeof(baudCodes) / sizeof(baudCodes[0]); i++) {
+        if (baudCodes[i].baud == baud) {
+            return baudCodes[i].code;
+        }
+    }
+    return -1;
+}
+
+// Writes the rate code to every axis on the bus (only those flagged in
+// 'acked' when onlyAcked is set). Returns 1 when all of them acknowledged.
+static uint8_t Motor_WriteBaudCode(uint8_t bus, uint16_t code, uint8_t *acked, uint8_t onlyAcked) {
+    Modbus_Response response;
+    uint8_t all = 1;
+
+    for (uint8_t i = 0; i < axes.count; i++) {
+        if (axes.axis[i].bus != bus || (onlyAcked && !acked[i])) {
+            continue;
+        }
+        Modbus_Request request = { axes.axis[i].slaveID, MODBUS_WRITE_SINGLE_REG, REG_BAUD_RATE, code, NULL,
+                                   MODBUS_PRIO_CONTROL, bus, 0, 0 };
+        acked[i] = (Modbus_Transaction(&request, &response) == MODBUS_OK);
+        all &= acked[i];
+    }
+    return all;
+}
+
+static HAL_StatusTypeDef Motor_SwitchBaud(uint8_t bus, uint32_t baud) {
+    ModbusRTU_Bus *rtu = ModbusRTU_GetBus(bus);
+
+    ModbusRTU_WaitTxIdle(rtu, MODBUS_RESPONSE_TIMEOUT_MS);
+    HAL_StatusTypeDef status = ModbusRTU_SetBaud(rtu, baud);
+
+    // RTT estimates and timeouts were measured at the old rate
+    for (uint8_t i = 0; i < axes.count; i++) {
+        if (axes.axis[i].bus == bus) {
+            Modbus_ResetSlaveStats(bus, axes.axis[i].slaveID);
+        }
+    }
+    return status;
+}
+
+static uint8_t Motor_VerifyBus(uint8_t bus) {
+    uint16_t status;
+
+    for (uint8_t i = 0; i < axes.count; i++) {
+        if (axes.axis[i].bus == bus && Modbus_ReadRegister(axes.axis[i].slaveID, REG_STATUS, &status) != MODBUS_OK) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static HAL_StatusTypeDef Motor_ChangeBusBaud(uint8_t bus, uint32_t baud, Motor_BaudResult *result) {
+    ModbusRTU_Bus *rtu = ModbusRTU_GetBus(bus);
+    uint8_t acked[MOTOR_MAX_AXES] = {0};
+
+    if (rtu == NULL) {
+        return HAL_ERROR;
+    }
+
+    uint32_t oldBaud = ModbusRTU_GetTiming(rtu)->baud;
+    int32_t newCode = Motor_BaudCodeOf(baud);
+    int32_t oldCode = Motor_BaudCodeOf(oldBaud);
+    int32_t errorPpm = ModbusRTU_BaudError(rtu, baud, &result->actualBaud);
+
+    result->baud = oldBaud;
+    result->errorPpm = errorPpm;
+    if (newCode < 0 || oldCode < 0
+        || errorPpm > MODBUS_BAUD_MAX_ERROR_PPM || errorPpm < -MODBUS_BAUD_MAX_ERROR_PPM) {
+        return HAL_ERROR;
+    }
+
+    // Every drive acknowledges at the old rate, then the master follows and
+    // checks each one answers at the new rate
+    if (Motor_WriteBaudCode(bus, (uint16_t)newCode, acked, 0)
+        && Motor_SwitchBaud(bus, baud) == HAL_OK && Motor_VerifyBus(bus)) {
+        result->baud = baud;
+        return HAL_OK;
+    }
+
+    // Roll back: drives that took the new code are listening at the new rate
+    uint8_t anyAcked = 0;
+    for (uint8_t i = 0; i < axes.count; i++) {
+        anyAcked |= acked[i];
+    }
+    if (anyAcked) {
+        Motor_SwitchBaud(bus, baud);
+        Motor_WriteBaudCode(bus, (uint16_t)oldCode, acked, 1);
+    }
+    Motor_SwitchBaud(bus, oldBaud);
+    result->rolledBack = 1;
+    result->errorPpm = ModbusRTU_BaudError(rtu, oldBaud, &result->actualBaud);
+    return HAL_TIMEOUT;
+}
+
+HAL_StatusTypeDef Motor_SetBusBaud(uint8_t bus, uint32_t baud, Motor_BaudResult *result) {
+    memset(result, 0, sizeof(*result));
+
+    // Profile and tension setpoints are queued from timer ISRs. Held off for
+    // the whole switch, they can neither keep the TX queue busy when the
+    // divider changes nor reach a drive at a rate it is not listening at.
+    // Gearing writes from the main loop, which is blocked in here.
+    Modbus_HoldStreams(bus, 1);
+    HAL_StatusTypeDef status = Motor_ChangeBusBaud(bus, baud, result);
+    Modbus_HoldStreams(bus, 0);
+    return status;
+}
+
+
+void Motor_RunRecipe(Motor_RecipeID id) {
+    uint8_t slaveIDs[MOTOR_MAX_AXES];
+    uint8_t count = 0;
+    Modbus_ShadowStats shadowBefore, shadowAfter;
+    Modbus_BatchStats batchBefore, batchAfter;
+
+    if (id >= MOTOR_RECIPE_COUNT) {
+        return;
+    }
+    const Motor_Recipe *recipe = &recipes[id];
+    Modbus_GetShadowStats(&shadowBefore);
+    Modbus_GetBatchStats(&batchBefore);
+
+    // Targets the drive already acknowledged are dropped by the shadow, the
+    // rest merge into one FC16 per contiguous run when the batch closes, so
+    // switching recipes only costs the registers that differ
+    Modbus_BeginBatch();
+    for (uint8_t i = 0; i < axes.count; i++) {
+        const Motor_Axis *axis = &axes.axis[i];
+        const Motor_RecipeTarget *target = &recipe->role[axis->role];
+        if (!target->used) {
+            continue;
+        }
+        Motor_SetDirection(axis->slaveID, target->direction);
+        Motor_SetSpeed(axis->slaveID, target->speed / axis->speedDivisor);
+        Motor_SetAcceleration(axis->slaveID, axis->acceleration);
+        Motor_SetTorqueLimit(axis->slaveID, axis->torqueLimit);
+        slaveIDs[count++] = axis->slaveID;
+        recipeStats.registers += 4;
+    }
+    Modbus_GetShadowStats(&shadowAfter);
+
+    recipeStats.runs++;
+    recipeStats.last = id;
+    recipeStats.suppressed += shadowAfter.hits - shadowBefore.hits;
+    if (count == 0) {
+        Modbus_EndBatch();
+        return;
+    }
+    Motor_SyncStart(slaveIDs, count);
+
+    Modbus_GetBatchStats(&batchAfter);
+    recipeStats.frames += (batchAfter.singleFrames + batchAfter.multiFrames)
+                          - (batchBefore.singleFrames + batchBefore.multiFrames);
 }
 
+void Motor_GetRecipeStats(Motor_RecipeStats *stats) {
+    *stats = recipeStats;
+}
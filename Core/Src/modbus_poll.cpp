@@ -0,0 +1,193 @@
+/*
+* modbus_poll.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+#include <string.h>
+#include "modbus_poll.h"
+#include "modbus_motor.h"
+#include "modbus_rtu.h"
+
+typedef struct {
+    uint8_t bus;
+    uint8_t slaveID;
+    uint8_t count;
+    uint16_t regAddress;
+    uint16_t periodMs;
+    uint16_t deadlineMs;
+    uint32_t releaseMs;       // Start of the current period
+    uint32_t loadPpm;         // Bus share claimed, parts per million
+    ModbusPoll_Callback onUpdate;
+    ModbusPoll_Snapshot snapshot[2];
+    volatile uint8_t published;
+    ModbusPoll_ItemStats stats;
+} ModbusPoll_Item;
+
+static ModbusPoll_Item items[MODBUS_POLL_MAX_ITEMS];
+static uint8_t rateOrder[MODBUS_POLL_MAX_ITEMS];   // Item indexes, shortest period first
+static uint8_t itemCount;
+static uint32_t loadPpm[MODBUS_BUS_COUNT];   // Admission is per bus, each line has its own budget
+
+
+static uint32_t ModbusPoll_CostUs(ModbusRTU_Bus *bus, uint8_t slaveID, uint8_t count) {
+    const ModbusRTU_Timing *timing = ModbusRTU_GetTiming(bus);
+    const Modbus_SlaveStats *stats = Modbus_GetSlaveStats(ModbusRTU_BusIndex(bus), slaveID);
+
+    // 8-byte request, 5 + 2n byte reply, a t3.5 after each. Once the slave has
+    // been measured its smoothed RTT covers the reply and turnaround.
+    uint32_t requestUs = 8 * timing->charUs + timing->t35Us;
+    if (stats != NULL && stats->samples != 0) {
+        return requestUs + stats->srttUs + timing->t35Us;
+    }
+    return requestUs + MODBUS_POLL_TURNAROUND_US + (5 + 2 * count) * timing->charUs + timing->t35Us;
+}
+
+static void ModbusPoll_Publish(ModbusPoll_Item *item, const Modbus_Response *response) {
+    uint8_t next = item->published ^ 1;
+    ModbusPoll_Snapshot *snapshot = &item->snapshot[next];
+
+    snapshot->tickMs = HAL_GetTick();
+    snapshot->status = response->status;
+    if (response->status == MODBUS_OK) {
+        snapshot->count = response->count;
+        memcpy(snapshot->values, response->registers, response->count * sizeof(uint16_t));
+    } else {
+        // Keep the last good values; the status tells the reader they are stale
+        snapshot->count = item->snapshot[item->published].count;
+        memcpy(snapshot->values, item->snapshot[item->published].values, sizeof(snapshot->values));
+    }
+
+    __DMB();
+    item->published = next;
+}
+
+void ModbusPoll_Init(void) {
+    memset(items, 0, sizeof(items));
+    itemCount = 0;
+    memset(loadPpm, 0, sizeof(loadPpm));
+}
+
+int8_t ModbusPoll_Add(uint8_t bus, uint8_t slaveID, uint16_t regAddress, uint8_t count,
+                      uint16_t periodMs, uint16_t deadlineMs, ModbusPoll_Callback onUpdate) {
+    ModbusRTU_Bus *rtu = ModbusRTU_GetBus(bus);
+
+    if (itemCount == MODBUS_POLL_MAX_ITEMS || count == 0 || count > MODBUS_POLL_MAX_REGS || periodMs == 0
+        || slaveID == MODBUS_BROADCAST_ID || rtu == NULL) {
+        return -1;
+    }
+
+    // Admission control keeps polling below its share of the bus
+    uint32_t itemPpm = ModbusPoll_CostUs(rtu, slaveID, count) * 1000 / periodMs;
+    if (loadPpm[bus] + itemPpm > MODBUS_POLL_MAX_LOAD * 10000U) {
+        return -1;
+    }
+
+    uint8_t index = itemCount;
+    uint8_t rank = itemCount;
+    while (rank > 0 && items[rateOrder[rank - 1]].periodMs > periodMs) {
+        rateOrder[rank] = rateOrder[rank - 1];
+        rank--;
+    }
+    rateOrder[rank] = index;
+
+    ModbusPoll_Item *item = &items[index];
+    memset(item, 0, sizeof(*item));
+    item->bus = bus;
+    item->slaveID = slaveID;
+    item->regAddress = regAddress;
+    item->count = count;
+    item->periodMs = periodMs;
+    item->deadlineMs = (deadlineMs != 0 && deadlineMs < periodMs) ? deadlineMs : periodMs;
+    item->releaseMs = HAL_GetTick();
+    item->loadPpm = itemPpm;
+    item->onUpdate = onUpdate;
+    item->snapshot[0].status = MODBUS_ERR_TIMEOUT;
+    item->snapshot[1].status = MODBUS_ERR_TIMEOUT;
+
+    itemCount++;
+    loadPpm[bus] += itemPpm;
+    return (int8_t)index;
+}
+
+void ModbusPoll_Service(void) {
+    Modbus_Request requests[MODBUS_POLL_BATCH];
+    Modbus_Response responses[MODBUS_POLL_BATCH];
+    uint8_t picked[MODBUS_POLL_BATCH];
+    uint8_t n = 0;
+    uint32_t now = HAL_GetTick();
+
+    // Shortest period first among the items that are due
+    for (uint8_t r = 0; r < itemCount && n < MODBUS_POLL_BATCH; r++) {
+        uint8_t i = rateOrder[r];
+        ModbusPoll_Item *item = &items[i];
+        if ((int32_t)(now - item->releaseMs) < 0) {
+            continue;
+        }
+
+        requests[n].slaveID = item->slaveID;
+        requests[n].functionCode = MODBUS_READ_HOLDING_REG;
+        requests[n].regAddress = item->regAddress;
+        requests[n].value = item->count;
+        requests[n].values = NULL;
+        requests[n].priority = MODBUS_PRIO_POLL;
+        requests[n].bus = item->bus;
+        picked[n++] = i;
+    }
+    if (n == 0) {
+        return;
+    }
+
+    // Pipelined in the poll lane: queued setpoints still overtake at each frame
+    // boundary, and reads for different buses are on the wire together
+    Modbus_TransactionBatch(requests, responses, n);
+
+    now = HAL_GetTick();
+    for (uint8_t k = 0; k < n; k++) {
+        ModbusPoll_Item *item = &items[picked[k]];
+        uint32_t latencyMs = now - item->releaseMs;
+
+        item->stats.polls++;
+        if (responses[k].status != MODBUS_OK) {
+            item->stats.errors++;
+        }
+        if (latencyMs > item->deadlineMs) {
+            item->stats.deadlineMisses++;
+        }
+        item->stats.lastLatencyMs = latencyMs;
+        if (latencyMs > item->stats.maxLatencyMs) {
+            item->stats.maxLatencyMs = latencyMs;
+        }
+
+        ModbusPoll_Publish(item, &responses[k]);
+        if (item->onUpdate != NULL) {
+            item->onUpdate(picked[k], &item->snapshot[item->published]);
+        }
+
+        // Keep the phase; periods that already passed are counted, not replayed
+        item->releaseMs += item->periodMs;
+        while ((int32_t)(now - item->releaseMs) >= (int32_t)item->periodMs) {
+            item->releaseMs += item->periodMs;
+            item->stats.skipped++;
+        }
+    }
+}
+
+uint8_t ModbusPoll_Read(uint8_t item, ModbusPoll_Snapshot *snapshot) {
+    if (item >= itemCount) {
+        return 0;
+    }
+    // The writer only ever fills the unpublished copy
+    *snapshot = items[item].snapshot[items[item].published];
+    return snapshot->status == MODBUS_OK;
+}
+
+const ModbusPoll_ItemStats *ModbusPoll_GetStats(uint8_t item) {
+    return (item < itemCount) ? &items[item].stats : NULL;
+}
+
+uint32_t ModbusPoll_GetLoad(uint8_t bus) {
+    // Estimated share of one bus claimed by the poll table in 0.01 % units
+    return (bus < MODBUS_BUS_COUNT) ? loadPpm[bus] / 100 : 0;
+}
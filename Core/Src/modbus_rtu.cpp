@@ -0,0 +1,917 @@
+/*
+* modbus_rtu.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+#include <string.h>
+#include "modbus_rtu.h"
+#include "modbus_crc.h"
+
+typedef struct {
+    uint16_t length;
+    uint32_t txStamp;                   // txCompleted when the frame ended
+    uint32_t endCycles;                 // DWT time of the IDLE after the last byte
+    uint8_t data[MODBUS_MAX_FRAME];
+} ModbusRTU_FrameSlot;
+
+typedef enum {
+    TX_SLOT_FREE = 0,
+    TX_SLOT_FILLING,                    // Claimed, frame being built in place
+    TX_SLOT_QUEUED,
+    TX_SLOT_ACTIVE,                     // On the wire
+    TX_SLOT_DONE                        // Sent; kept for ModbusRTU_TxDone until reused
+} ModbusRTU_TxState;
+
+typedef struct {
+    volatile uint8_t state;
+    uint8_t priority;
+    uint16_t length;
+    uint32_t ticket;                    // Queue order within a priority
+    uint32_t replyUs;                   // How long to hold the bus for a reply
+    uint32_t queuedCycles;              // DWT time the frame became eligible
+    uint32_t endCycles;                 // DWT time of the final stop bit
+    uint32_t replyStamp;                // txCompleted value its reply ends under
+    uint8_t data[MODBUS_MAX_FRAME];
+} ModbusRTU_TxSlot;
+
+#define MODBUS_TX_POOL           (MODBUS_TX_FRAME_SLOTS + MODBUS_TX_ESTOP_SLOTS)
+
+struct ModbusRTU_Bus {
+    uint8_t index;
+    UART_HandleTypeDef *huart;
+    TIM_HandleTypeDef *htim;          // One-pulse silence timer, 1 us per tick
+
+    // RS-485 driver enable, NULL when the transceiver switches on its own
+    GPIO_TypeDef *dePort;
+    uint16_t dePin;
+    ModbusRTU_DeStats deStats;
+
+    // DMA writes here continuously; rxDmaTail is the first byte not yet consumed
+    uint8_t rxDma[MODBUS_RX_DMA_SIZE];
+    uint16_t rxDmaTail;
+
+    // Frames are assembled straight into rxSlots[rxHead]. That slot is never
+    // visible to the reader until rxHead moves past it, so no extra copy is needed.
+    ModbusRTU_FrameSlot rxSlots[MODBUS_RX_FRAME_SLOTS];
+    volatile uint8_t rxHead;     // Advanced by the ISR only
+    volatile uint8_t rxTail;     // Advanced by the main loop only
+    uint8_t rxDiscard;           // Current frame is corrupt or too long
+    uint16_t rxCrc;              // Running CRC over the frame being assembled
+    uint32_t rxIdleCycles;       // DWT time of the latest IDLE event
+    volatile uint32_t rxBadStamp; // txCompleted when a corrupt frame was dropped
+
+    volatile ModbusRTU_RxStats rxStats;
+
+    // TX pool: producers claim a slot, the ISRs pick the most urgent queued
+    // frame at every frame boundary. The e-stop lane may also be fed from an ISR.
+    ModbusRTU_TxSlot txSlots[MODBUS_TX_FRAME_SLOTS + MODBUS_TX_ESTOP_SLOTS];
+    ModbusRTU_TxSlot *volatile txCurrent;
+    volatile uint8_t txActive;
+    uint32_t txPreemptions;
+    uint32_t estopFrames;
+    uint32_t estopLastUs;
+    uint32_t estopMaxUs;
+    volatile uint32_t txCompleted;
+    volatile uint32_t txDoneCycles;
+    uint32_t txQueued;
+    uint32_t txDropped;
+    uint32_t txCancelled;
+    uint32_t txStartFailures;
+    uint8_t txHighWater;
+
+    uint32_t txStartCycles;
+    uint32_t copiedBytes;        // Frame bytes memcpy'd into TX or out of RX slots
+    volatile uint32_t ringCopiedBytes;  // Bytes memcpy'd from the DMA ring into RX slots, ISR only
+
+    // Line utilization; the slot index of a TX frame is its ticket modulo the
+    // queue size, so tickets stay valid while the frame is in the queue
+    ModbusRTU_LineStats lineStats;
+    uint32_t lineResetTick;
+    uint32_t lineResetBytes;
+    uint32_t lineFreeCycles;     // End of the latest activity on the wire
+    uint8_t lineFreeValid;       // lineFreeCycles is inside the current window
+
+    // Silence timer: one-pulse, CC1 at t1.5 and update at t3.5 after the
+    // last line activity. The bus is free for the next request only after t3.5.
+    ModbusRTU_Timing timing;
+    volatile uint8_t busIdle;
+    uint16_t silenceRefPos;      // RX DMA position when the timer was armed
+    uint16_t silenceT15Pos;      // RX DMA position sampled at t1.5
+    uint8_t silenceCheckGap;     // Armed by RX, so t1.5 violations count
+};
+
+// Each bus owns its USART, DMA streams and timer; nothing is shared between them
+static ModbusRTU_Bus buses[MODBUS_BUS_COUNT];
+
+
+static uint16_t ModbusRTU_RxDmaPos(ModbusRTU_Bus *bus) {
+    return (uint16_t)((MODBUS_RX_DMA_SIZE - __HAL_DMA_GET_COUNTER(bus->huart->hdmarx)) % MODBUS_RX_DMA_SIZE);
+}
+
+static void ModbusRTU_ArmSilence(ModbusRTU_Bus *bus, uint32_t t15Us, uint32_t t35Us, uint8_t checkGap) {
+    __HAL_TIM_DISABLE(bus->htim);
+    __HAL_TIM_SET_COUNTER(bus->htim, 0);
+    __HAL_TIM_SET_COMPARE(bus->htim, TIM_CHANNEL_1, t15Us);
+    __HAL_TIM_SET_AUTORELOAD(bus->htim, t35Us);
+    __HAL_TIM_CLEAR_IT(bus->htim, TIM_IT_CC1 | TIM_IT_UPDATE);
+
+    bus->busIdle = 0;
+    bus->silenceRefPos = ModbusRTU_RxDmaPos(bus);
+    bus->silenceT15Pos = bus->silenceRefPos;
+    bus->silenceCheckGap = checkGap;
+
+    __HAL_TIM_ENABLE_IT(bus->htim, TIM_IT_CC1 | TIM_IT_UPDATE);
+    __HAL_TIM_ENABLE(bus->htim);
+}
+
+static void ModbusRTU_StartRx(ModbusRTU_Bus *bus) {
+    bus->rxDmaTail = 0;
+    bus->rxSlots[bus->rxHead].length = 0;
+    bus->rxDiscard = 0;
+    bus->rxCrc = MODBUS_CRC_INIT;
+
+    // Circular mode: HT, TC and IDLE all end up in HAL_UARTEx_RxEventCallback
+    if (HAL_UARTEx_ReceiveToIdle_DMA(bus->huart, bus->rxDma, MODBUS_RX_DMA_SIZE) != HAL_OK) {
+        Error_Handler();
+    }
+}
+
+static void ModbusRTU_Append(ModbusRTU_Bus *bus, const uint8_t *src, uint16_t count) {
+    ModbusRTU_FrameSlot *slot = &bus->rxSlots[bus->rxHead];
+
+    bus->rxStats.bytes += count;
+    if (slot->length + count > MODBUS_MAX_FRAME) {
+        if (!bus->rxDiscard) {
+            bus->rxStats.oversize++;
+        }
+        bus->rxDiscard = 1;
+        count = MODBUS_MAX_FRAME - slot->length;
+    }
+    memcpy(&slot->data[slot->length], src, count);
+    bus->ringCopiedBytes += count;
+    bus->rxCrc = ModbusCRC_Update(bus->rxCrc, src, count);
+    slot->length += count;
+}
+
+static void ModbusRTU_Drain(ModbusRTU_Bus *bus, uint16_t dmaPos) {
+    // dmaPos equals MODBUS_RX_DMA_SIZE on the TC event, i.e. the ring just wrapped
+    if (dmaPos < bus->rxDmaTail) {
+        ModbusRTU_Append(bus, &bus->rxDma[bus->rxDmaTail], MODBUS_RX_DMA_SIZE - bus->rxDmaTail);
+        bus->rxDmaTail = 0;
+    }
+    if (dmaPos > bus->rxDmaTail) {
+        ModbusRTU_Append(bus, &bus->rxDma[bus->rxDmaTail], dmaPos - bus->rxDmaTail);
+    }
+    bus->rxDmaTail = (dmaPos >= MODBUS_RX_DMA_SIZE) ? 0 : dmaPos;
+}
+
+static void ModbusRTU_EndFrame(ModbusRTU_Bus *bus) {
+    ModbusRTU_FrameSlot *slot = &bus->rxSlots[bus->rxHead];
+    uint8_t next = (bus->rxHead + 1) % MODBUS_RX_FRAME_SLOTS;
+
+    if (slot->length == 0) {
+        bus->rxDiscard = 0;
+        bus->rxCrc = MODBUS_CRC_INIT;
+        return;
+    }
+
+    // The CRC was accumulated chunk by chunk as bytes landed; running it over
+    // the trailing CRC bytes as well leaves zero for an intact frame.
+    // Discarded frames were already counted where they were marked bad.
+    if (!bus->rxDiscard) {
+        if (slot->length < MODBUS_MIN_FRAME || bus->rxCrc != 0) {
+            bus->rxStats.crcErrors++;
+            bus->rxBadStamp = bus->txCompleted;
+        } else if (next == bus->rxTail) {
+            bus->rxStats.overflows++;
+        } else {
+            bus->rxStats.frames++;
+            slot->txStamp = bus->txCompleted;
+            slot->endCycles = bus->rxIdleCycles;
+            bus->rxHead = next;
+        }
+    } else {
+        bus->rxBadStamp = bus->txCompleted;
+    }
+
+    bus->rxSlots[bus->rxHead].length = 0;
+    bus->rxDiscard = 0;
+    bus->rxCrc = MODBUS_CRC_INIT;
+}
+
+static void ModbusRTU_LineIdle(ModbusRTU_Bus *bus) {
+    bus->rxIdleCycles = DWT->CYCCNT;
+    bus->lineFreeCycles = bus->rxIdleCycles - MODBUS_US_TO_CYCLES(bus->timing.charUs);
+    bus->lineFreeValid = 1;
+
+    // IDLE fires one character time after the last stop bit, so only the
+    // remainder of t1.5/t3.5 is left to run on the timer
+    uint32_t t15 = (bus->timing.t15Us > bus->timing.charUs) ? bus->timing.t15Us - bus->timing.charUs : 1;
+    uint32_t t35 = (bus->timing.t35Us > bus->timing.charUs) ? bus->timing.t35Us - bus->timing.charUs : 1;
+    ModbusRTU_ArmSilence(bus, t15, t35, 1);
+}
+
+static ModbusRTU_TxSlot *ModbusRTU_NextTx(ModbusRTU_Bus *bus) {
+    ModbusRTU_TxSlot *best = NULL;
+
+    for (uint8_t i = 0; i < MODBUS_TX_POOL; i++) {
+        ModbusRTU_TxSlot *slot = &bus->txSlots[i];
+        if (slot->state != TX_SLOT_QUEUED) {
+            continue;
+        }
+        if (best == NULL || slot->priority > best->priority
+            || (slot->priority == best->priority && (int32_t)(slot->ticket - best->ticket) < 0)) {
+            best = slot;
+        }
+    }
+    return best;
+}
+
+static void ModbusRTU_StartTx(ModbusRTU_Bus *bus, ModbusRTU_TxSlot *slot) {
+    // Caller guarantees a queued slot, no transfer in flight and t3.5 elapsed
+    bus->txActive = 1;
+    bus->busIdle = 0;
+    bus->txStartCycles = DWT->CYCCNT;
+    slot->state = TX_SLOT_ACTIVE;
+    slot->replyStamp = bus->txCompleted + 1;
+    bus->txCurrent = slot;
+
+    if (bus->dePort != NULL) {
+        // Transceiver enable time is a fraction of the start bit
+        bus->dePort->BSRR = bus->dePin;
+    }
+    if (HAL_UART_Transmit_DMA(bus->huart, slot->data, slot->length) != HAL_OK) {
+        // Never stop here from an ISR with the driver on: free the line, put
+        // the frame back in the queue and try again after another t3.5
+        if (bus->dePort != NULL) {
+            bus->dePort->BSRR = (uint32_t)bus->dePin << 16U;
+        }
+        bus->txStartFailures++;
+        slot->state = TX_SLOT_QUEUED;
+        bus->txCurrent = NULL;
+        bus->txActive = 0;
+        ModbusRTU_ArmSilence(bus, bus->timing.t35Us, bus->timing.t35Us, 0);
+        return;
+    }
+
+    // Anything older still waiting was overtaken by a more urgent frame
+    for (uint8_t i = 0; i < MODBUS_TX_POOL; i++) {
+        if (bus->txSlots[i].state == TX_SLOT_QUEUED && (int32_t)(bus->txSlots[i].ticket - slot->ticket) < 0) {
+            bus->txPreemptions++;
+            break;
+        }
+    }
+    if (slot->priority == MODBUS_PRIO_ESTOP) {
+        bus->estopFrames++;
+        bus->estopLastUs = MODBUS_CYCLES_TO_US(bus->txStartCycles - slot->queuedCycles);
+        if (bus->estopLastUs > bus->estopMaxUs) {
+            bus->estopMaxUs = bus->estopLastUs;
+        }
+    }
+    if (bus->lineFreeValid) {
+        uint32_t gapUs = MODBUS_CYCLES_TO_US(bus->txStartCycles - bus->lineFreeCycles);
+        bus->lineStats.gapCount++;
+        bus->lineStats.gapTotalUs += gapUs;
+        if (gapUs > bus->lineStats.gapMaxUs) {
+            bus->lineStats.gapMaxUs = gapUs;
+        }
+        bus->lineFreeValid = 0;
+    }
+}
+
+static uint8_t ModbusRTU_TxDepth(ModbusRTU_Bus *bus) {
+    uint8_t depth = 0;
+
+    for (uint8_t i = 0; i < MODBUS_TX_POOL; i++) {
+        if (bus->txSlots[i].state == TX_SLOT_QUEUED || bus->txSlots[i].state == TX_SLOT_ACTIVE) {
+            depth++;
+        }
+    }
+    return depth;
+}
+
+static void ModbusRTU_KickTx(ModbusRTU_Bus *bus) {
+    // Called with interrupts masked or from an ISR
+    if (!bus->txActive && bus->busIdle) {
+        ModbusRTU_TxSlot *slot = ModbusRTU_NextTx(bus);
+        if (slot != NULL) {
+            ModbusRTU_StartTx(bus, slot);
+        }
+    }
+}
+
+static ModbusRTU_TxSlot *ModbusRTU_FindTicket(ModbusRTU_Bus *bus, uint32_t ticket) {
+    for (uint8_t i = 0; i < MODBUS_TX_POOL; i++) {
+        if (bus->txSlots[i].state != TX_SLOT_FREE && bus->txSlots[i].ticket == ticket) {
+            return &bus->txSlots[i];
+        }
+    }
+    return NULL;
+}
+
+static ModbusRTU_Bus *ModbusRTU_FromUart(UART_HandleTypeDef *huart) {
+    for (uint8_t i = 0; i < MODBUS_BUS_COUNT; i++) {
+        if (buses[i].huart == huart) {
+            return &buses[i];
+        }
+    }
+    return NULL;
+}
+
+static ModbusRTU_Bus *ModbusRTU_FromTimer(TIM_HandleTypeDef *htim) {
+    for (uint8_t i = 0; i < MODBUS_BUS_COUNT; i++) {
+        if (buses[i].htim == htim) {
+            return &buses[i];
+        }
+    }
+    return NULL;
+}
+
+ModbusRTU_Bus *ModbusRTU_Init(uint8_t index, UART_HandleTypeDef *huart, TIM_HandleTypeDef *htim) {
+    if (index >= MODBUS_BUS_COUNT) {
+        return NULL;
+    }
+
+    ModbusRTU_Bus *bus = &buses[index];
+    memset((void *)bus, 0, sizeof(*bus));
+    bus->index = index;
+    bus->huart = huart;
+    bus->htim = htim;
+    ModbusRTU_UpdateTiming(bus);
+    bus->busIdle = 1;
+
+    // Free-running cycle counter for RTT and latency measurements
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    ModbusRTU_StartRx(bus);
+    return bus;
+}
+
+void ModbusRTU_SetDriverEnable(ModbusRTU_Bus *bus, GPIO_TypeDef *port, uint16_t pin) {
+    if (port != NULL) {
+        port->BSRR = (uint32_t)pin << 16U;
+    }
+    bus->dePort = port;
+    bus->dePin = pin;
+}
+
+void ModbusRTU_GetDeStats(ModbusRTU_Bus *bus, ModbusRTU_DeStats *stats) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = bus->deStats;
+    __set_PRIMASK(primask);
+}
+
+ModbusRTU_Bus *ModbusRTU_GetBus(uint8_t index) {
+    // NULL for a bus that was never initialised
+    if (index >= MODBUS_BUS_COUNT || buses[index].huart == NULL) {
+        return NULL;
+    }
+    return &buses[index];
+}
+
+uint8_t ModbusRTU_BusIndex(const ModbusRTU_Bus *bus) {
+    return bus->index;
+}
+
+void ModbusRTU_UpdateTiming(ModbusRTU_Bus *bus) {
+    UART_InitTypeDef *init = &bus->huart->Init;
+    uint32_t bits = 1 + ((init->WordLength == UART_WORDLENGTH_9B) ? 9 : 8)
+                      + ((init->StopBits == UART_STOPBITS_2) ? 2 : 1);
+
+    // Round up so the timer never ends a silence early
+    bus->timing.baud = init->BaudRate;
+    bus->timing.charUs = (bits * MODBUS_TIMER_TICK_HZ + init->BaudRate - 1) / init->BaudRate;
+    if (init->BaudRate > MODBUS_FIXED_TIMING_BAUD) {
+        bus->timing.t15Us = MODBUS_T15_FIXED_US;
+        bus->timing.t35Us = MODBUS_T35_FIXED_US;
+    } else {
+        bus->timing.t15Us = (bus->timing.charUs * 3 + 1) / 2;
+        bus->timing.t35Us = (bus->timing.charUs * 7 + 1) / 2;
+    }
+}
+
+const ModbusRTU_Timing *ModbusRTU_GetTiming(ModbusRTU_Bus *bus) {
+    return &bus->timing;
+}
+
+static uint32_t ModbusRTU_Pclk(const ModbusRTU_Bus *bus) {
+    // USART1 and USART6 sit on APB2 (96 MHz), the others on APB1
+    if (bus->huart->Instance == USART1 || bus->huart->Instance == USART6) {
+        return HAL_RCC_GetPCLK2Freq();
+    }
+    return HAL_RCC_GetPCLK1Freq();
+}
+
+int32_t ModbusRTU_BaudError(ModbusRTU_Bus *bus, uint32_t baud, uint32_t *actualBaud) {
+    uint32_t pclk = ModbusRTU_Pclk(bus);
+    uint32_t divisor;
+
+    if (baud == 0) {
+        return INT32_MAX;
+    }
+
+    // Same BRR rounding as HAL_UART_Init; the line then runs at pclk / divisor
+    if (bus->huart->Init.OverSampling == UART_OVERSAMPLING_8) {
+        uint32_t brr = UART_BRR_SAMPLING8(pclk, baud);
+        divisor = ((brr >> 4) << 3) + (brr & 0x07);
+    } else {
+        divisor = UART_BRR_SAMPLING16(pclk, baud);
+    }
+    if (divisor == 0) {
+        return INT32_MAX;
+    }
+
+    if (actualBaud != NULL) {
+        *actualBaud = (pclk + divisor / 2) / divisor;
+    }
+    int64_t nominal = (int64_t)baud * divisor;
+    return (int32_t)(((int64_t)pclk - nominal) * 1000000 / nominal);
+}
+
+HAL_StatusTypeDef ModbusRTU_SetBaud(ModbusRTU_Bus *bus, uint32_t baud) {
+    int32_t errorPpm = ModbusRTU_BaudError(bus, baud, NULL);
+    uint32_t primask;
+
+    if (errorPpm > MODBUS_BAUD_MAX_ERROR_PPM || errorPpm < -MODBUS_BAUD_MAX_ERROR_PPM) {
+        return HAL_ERROR;
+    }
+
+    // Hold the queue: nothing may start while the divider changes
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (ModbusRTU_TxDepth(bus) != 0) {
+        __set_PRIMASK(primask);
+        return HAL_BUSY;
+    }
+    bus->busIdle = 0;
+    __HAL_TIM_DISABLE(bus->htim);
+    __HAL_TIM_DISABLE_IT(bus->htim, TIM_IT_CC1 | TIM_IT_UPDATE);
+    __set_PRIMASK(primask);
+
+    HAL_UART_AbortReceive(bus->huart);
+    bus->huart->Init.BaudRate = baud;
+    if (HAL_UART_Init(bus->huart) != HAL_OK) {
+        Error_Handler();
+    }
+    ModbusRTU_UpdateTiming(bus);
+
+    // Frames received at the old rate are meaningless now. The first request
+    // waits for a full t3.5 at the new rate.
+    bus->rxTail = bus->rxHead;
+    ModbusRTU_StartRx(bus);
+    ModbusRTU_ArmSilence(bus, bus->timing.t15Us, bus->timing.t35Us, 0);
+    return HAL_OK;
+}
+
+void ModbusRTU_FlushRx(ModbusRTU_Bus *bus) {
+    // Drop frames nobody asked for, e.g. FC06 echoes of fire-and-forget writes
+    bus->rxTail = bus->rxHead;
+}
+
+uint16_t ModbusRTU_ReadFrame(ModbusRTU_Bus *bus, uint8_t *frame, uint16_t maxLength) {
+    return ModbusRTU_ReadFrameStamped(bus, frame, maxLength, NULL);
+}
+
+uint16_t ModbusRTU_ReadFrameStamped(ModbusRTU_Bus *bus, uint8_t *frame, uint16_t maxLength, uint32_t *endCycles) {
+    if (bus->rxTail == bus->rxHead) {
+        return 0;
+    }
+
+    const ModbusRTU_FrameSlot *slot = &bus->rxSlots[bus->rxTail];
+    uint16_t length = (slot->length < maxLength) ? slot->length : maxLength;
+    memcpy(frame, slot->data, length);
+    bus->copiedBytes += length;
+    if (endCycles != NULL) {
+        *endCycles = slot->endCycles;
+    }
+    bus->rxTail = (bus->rxTail + 1) % MODBUS_RX_FRAME_SLOTS;
+    return length;
+}
+
+uint16_t ModbusRTU_WaitFrame(ModbusRTU_Bus *bus, uint8_t *frame, uint16_t maxLength, uint32_t timeoutMs) {
+    uint32_t start = HAL_GetTick();
+
+    do {
+        uint16_t length = ModbusRTU_ReadFrame(bus, frame, maxLength);
+        if (length != 0) {
+            return length;
+        }
+    } while ((HAL_GetTick() - start) < timeoutMs);
+
+    return 0;
+}
+
+const volatile ModbusRTU_RxStats *ModbusRTU_GetRxStats(ModbusRTU_Bus *bus) {
+    return &bus->rxStats;
+}
+
+HAL_StatusTypeDef ModbusRTU_SendFrame(ModbusRTU_Bus *bus, const uint8_t *frame, uint16_t length) {
+    return ModbusRTU_SendRequest(bus, frame, length, 0, MODBUS_PRIO_CONTROL, NULL);
+}
+
+static ModbusRTU_TxSlot *ModbusRTU_ClaimTx(ModbusRTU_Bus *bus, uint8_t priority) {
+    ModbusRTU_TxSlot *claim = NULL;
+    uint8_t available = 0;
+
+    // Free slots first, then the oldest sent frame
+    for (uint8_t i = 0; i < MODBUS_TX_POOL; i++) {
+        ModbusRTU_TxSlot *slot = &bus->txSlots[i];
+        if (slot->state == TX_SLOT_FREE) {
+            available++;
+            if (claim == NULL || claim->state != TX_SLOT_FREE) {
+                claim = slot;
+            }
+        } else if (slot->state == TX_SLOT_DONE) {
+            available++;
+            if (claim == NULL || (claim->state == TX_SLOT_DONE && (int32_t)(slot->ticket - claim->ticket) < 0)) {
+                claim = slot;
+            }
+        }
+    }
+
+    // The last MODBUS_TX_ESTOP_SLOTS slots are kept for the e-stop lane
+    if (priority != MODBUS_PRIO_ESTOP && available <= MODBUS_TX_ESTOP_SLOTS) {
+        return NULL;
+    }
+    if (claim != NULL) {
+        claim->state = TX_SLOT_FILLING;
+        claim->ticket = bus->txQueued++;
+    }
+    return claim;
+}
+
+uint8_t *ModbusRTU_ClaimFrame(ModbusRTU_Bus *bus, uint8_t priority) {
+    uint32_t primask = __get_PRIMASK();
+    ModbusRTU_TxSlot *slot;
+
+    __disable_irq();
+    slot = ModbusRTU_ClaimTx(bus, priority);
+    if (slot == NULL) {
+        bus->txDropped++;
+    } else {
+        slot->priority = priority;
+    }
+    __set_PRIMASK(primask);
+    return (slot != NULL) ? slot->data : NULL;
+}
+
+static ModbusRTU_TxSlot *ModbusRTU_FillingSlot(ModbusRTU_Bus *bus, const uint8_t *frame) {
+    for (uint8_t i = 0; i < MODBUS_TX_POOL; i++) {
+        if (bus->txSlots[i].data == frame && bus->txSlots[i].state == TX_SLOT_FILLING) {
+            return &bus->txSlots[i];
+        }
+    }
+    return NULL;
+}
+
+HAL_StatusTypeDef ModbusRTU_CommitFrame(ModbusRTU_Bus *bus, uint8_t *frame, uint16_t length,
+                                       uint32_t replyTimeoutUs, uint32_t *ticket) {
+    ModbusRTU_TxSlot *slot = ModbusRTU_FillingSlot(bus, frame);
+    uint32_t primask;
+
+    if (slot == NULL) {
+        return HAL_ERROR;
+    }
+    if (length == 0 || length > MODBUS_MAX_FRAME) {
+        // Nothing valid was built; the slot goes back to the pool unsent
+        slot->state = TX_SLOT_FREE;
+        return HAL_ERROR;
+    }
+
+    slot->length = length;
+    slot->replyUs = replyTimeoutUs;
+    if (ticket != NULL) {
+        *ticket = slot->ticket;
+    }
+
+    // The TC callback or silence timer may be starting a frame right now.
+    // If the bus is not idle yet the t3.5 expiry starts the transfer.
+    primask = __get_PRIMASK();
+    __disable_irq();
+    slot->queuedCycles = DWT->CYCCNT;
+    slot->state = TX_SLOT_QUEUED;
+    uint8_t depth = ModbusRTU_TxDepth(bus);
+    if (depth > bus->txHighWater) {
+        bus->txHighWater = depth;
+    }
+    ModbusRTU_KickTx(bus);
+    __set_PRIMASK(primask);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef ModbusRTU_SendRequest(ModbusRTU_Bus *bus, const uint8_t *frame, uint16_t length,
+                                        uint32_t replyTimeoutUs, uint8_t priority, uint32_t *ticket) {
+    if (length == 0 || length > MODBUS_MAX_FRAME) {
+        return HAL_ERROR;
+    }
+
+    uint8_t *data = ModbusRTU_ClaimFrame(bus, priority);
+    if (data == NULL) {
+        return HAL_BUSY;
+    }
+    memcpy(data, frame, length);
+    bus->copiedBytes += length;
+    return ModbusRTU_CommitFrame(bus, data, length, replyTimeoutUs, ticket);
+}
+
+uint8_t ModbusRTU_WaitTxIdle(ModbusRTU_Bus *bus, uint32_t timeoutMs) {
+    uint32_t start = HAL_GetTick();
+
+    // Queued frames count too: they may be waiting on a reply window
+    while (ModbusRTU_TxDepth(bus) != 0) {
+        if ((HAL_GetTick() - start) >= timeoutMs) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+uint32_t ModbusRTU_GetTxCompleted(ModbusRTU_Bus *bus) {
+    return bus->txCompleted;
+}
+
+uint32_t ModbusRTU_GetTxDoneCycles(ModbusRTU_Bus *bus) {
+    return bus->txDoneCycles;
+}
+
+uint32_t ModbusRTU_Cycles(void) {
+    return DWT->CYCCNT;
+}
+
+uint8_t ModbusRTU_TxDone(ModbusRTU_Bus *bus, uint32_t ticket, uint32_t *doneCycles, uint32_t *replyStamp) {
+    uint32_t primask = __get_PRIMASK();
+    uint8_t done = 1;
+
+    __disable_irq();
+    const ModbusRTU_TxSlot *slot = ModbusRTU_FindTicket(bus, ticket);
+    if (slot == NULL) {
+        // Sent so long ago the slot was reused; no reply can be matched
+        *doneCycles = DWT->CYCCNT;
+        *replyStamp = 0;
+    } else if (slot->state == TX_SLOT_DONE) {
+        *doneCycles = slot->endCycles;
+        *replyStamp = slot->replyStamp;
+    } else {
+        done = 0;
+    }
+    __set_PRIMASK(primask);
+    return done;
+}
+
+uint32_t ModbusRTU_FrameUs(ModbusRTU_Bus *bus, uint32_t ticket) {
+    uint32_t primask = __get_PRIMASK();
+    uint32_t us = 0;
+
+    __disable_irq();
+    const ModbusRTU_TxSlot *slot = ModbusRTU_FindTicket(bus, ticket);
+    if (slot != NULL) {
+        us = slot->length * bus->timing.charUs + bus->timing.t35Us;
+    }
+    __set_PRIMASK(primask);
+    return us;
+}
+
+uint8_t ModbusRTU_CancelTx(ModbusRTU_Bus *bus, uint32_t ticket) {
+    uint32_t primask = __get_PRIMASK();
+    uint8_t cancelled = 0;
+
+    // Masked so the silence timer cannot start it while it is withdrawn
+    __disable_irq();
+    ModbusRTU_TxSlot *slot = ModbusRTU_FindTicket(bus, ticket);
+    if (slot != NULL && slot->state == TX_SLOT_QUEUED) {
+        slot->state = TX_SLOT_FREE;
+        bus->txCancelled++;
+        cancelled = 1;
+    }
+    __set_PRIMASK(primask);
+    return cancelled;
+}
+
+const uint8_t *ModbusRTU_PeekReply(ModbusRTU_Bus *bus, uint32_t replyStamp, uint16_t *length,
+                                   uint32_t *endCycles) {
+    // A reply ends after its request's stop bit and before anything queued
+    // behind it is released, i.e. while bus->txCompleted still equals replyStamp
+    if (replyStamp == 0) {
+        return NULL;
+    }
+    ModbusRTU_DiscardRxBefore(bus, replyStamp);
+    if (bus->rxTail == bus->rxHead || bus->rxSlots[bus->rxTail].txStamp != replyStamp) {
+        return NULL;
+    }
+
+    // The ISR only ever fills rxSlots[rxHead] and never advances onto rxTail,
+    // so the slot stays put until ModbusRTU_ReleaseFrame
+    const ModbusRTU_FrameSlot *slot = &bus->rxSlots[bus->rxTail];
+    *length = slot->length;
+    if (endCycles != NULL) {
+        *endCycles = slot->endCycles;
+    }
+    return slot->data;
+}
+
+void ModbusRTU_ReleaseFrame(ModbusRTU_Bus *bus) {
+    if (bus->rxTail != bus->rxHead) {
+        bus->rxTail = (bus->rxTail + 1) % MODBUS_RX_FRAME_SLOTS;
+    }
+}
+
+uint16_t ModbusRTU_ReadReply(ModbusRTU_Bus *bus, uint32_t replyStamp, uint8_t *frame, uint16_t maxLength,
+                             uint32_t *endCycles) {
+    uint16_t length;
+    const uint8_t *data = ModbusRTU_PeekReply(bus, replyStamp, &length, endCycles);
+
+    if (data == NULL) {
+        return 0;
+    }
+    if (length > maxLength) {
+        length = maxLength;
+    }
+    memcpy(frame, data, length);
+    bus->copiedBytes += length;
+    ModbusRTU_ReleaseFrame(bus);
+    return length;
+}
+
+uint8_t ModbusRTU_ReplyCorrupt(ModbusRTU_Bus *bus, uint32_t replyStamp) {
+    return replyStamp != 0 && bus->rxBadStamp == replyStamp;
+}
+
+void ModbusRTU_DiscardRxBefore(ModbusRTU_Bus *bus, uint32_t txStamp) {
+    // A reply can only end after its request has left the wire, so anything
+    // stamped earlier belongs to a previous request
+    while (bus->rxTail != bus->rxHead && (int32_t)(bus->rxSlots[bus->rxTail].txStamp - txStamp) < 0) {
+        bus->rxTail = (bus->rxTail + 1) % MODBUS_RX_FRAME_SLOTS;
+    }
+}
+
+void ModbusRTU_GetTxStats(ModbusRTU_Bus *bus, ModbusRTU_TxStats *stats) {
+    stats->queued = bus->txQueued;
+    stats->sent = bus->txCompleted;
+    stats->dropped = bus->txDropped;
+    stats->cancelled = bus->txCancelled;
+    stats->startFailures = bus->txStartFailures;
+    stats->depth = ModbusRTU_TxDepth(bus);
+    stats->highWater = bus->txHighWater;
+    stats->preemptions = bus->txPreemptions;
+    stats->estopFrames = bus->estopFrames;
+    stats->estopLastUs = bus->estopLastUs;
+    stats->estopMaxUs = bus->estopMaxUs;
+}
+
+uint32_t ModbusRTU_GetCopiedBytes(ModbusRTU_Bus *bus) {
+    return bus->copiedBytes + bus->ringCopiedBytes;
+}
+
+void ModbusRTU_ResetLineStats(ModbusRTU_Bus *bus) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&bus->lineStats, 0, sizeof(bus->lineStats));
+    bus->lineResetTick = HAL_GetTick();
+    bus->lineResetBytes = bus->rxStats.bytes;
+    bus->lineFreeValid = 0;
+    __set_PRIMASK(primask);
+}
+
+void ModbusRTU_GetLineStats(ModbusRTU_Bus *bus, ModbusRTU_LineStats *stats) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = bus->lineStats;
+    stats->rxBusyUs = (bus->rxStats.bytes - bus->lineResetBytes) * bus->timing.charUs;
+    __set_PRIMASK(primask);
+    stats->windowMs = HAL_GetTick() - bus->lineResetTick;
+}
+
+void ModbusRTU_IRQHandler(UART_HandleTypeDef *huart) {
+    ModbusRTU_Bus *bus = ModbusRTU_FromUart(huart);
+    if (bus == NULL) {
+        return;
+    }
+
+    // TC is only enabled once the TX DMA has drained, so it marks the last
+    // stop bit. Drop DE here, ahead of HAL's flag handling; the slave's reply
+    // cannot start before its own t3.5, so it is never clipped.
+    if (bus->dePort != NULL && __HAL_UART_GET_FLAG(huart, UART_FLAG_TC)
+        && __HAL_UART_GET_IT_SOURCE(huart, UART_IT_TC)) {
+        uint32_t start = DWT->CYCCNT;
+        bus->dePort->BSRR = (uint32_t)bus->dePin << 16U;
+        uint8_t high = (bus->dePort->IDR & bus->dePin) != 0;
+        uint32_t switchNs = MODBUS_CYCLES_TO_NS(DWT->CYCCNT - start);
+
+        bus->deStats.releases++;
+        bus->deStats.lastPinSwitchNs = switchNs;
+        if (switchNs > bus->deStats.maxPinSwitchNs) {
+            bus->deStats.maxPinSwitchNs = switchNs;
+        }
+        if (high) {
+            bus->deStats.stuck++;
+        }
+    }
+
+    // HAL suppresses the IDLE callback when the line goes idle exactly on a
+    // ring wrap (DMA counter reloaded to full). Start the silence ourselves.
+    if (__HAL_UART_GET_FLAG(bus->huart, UART_FLAG_IDLE)
+        && __HAL_UART_GET_IT_SOURCE(bus->huart, UART_IT_IDLE)
+        && __HAL_DMA_GET_COUNTER(bus->huart->hdmarx) == MODBUS_RX_DMA_SIZE) {
+        ModbusRTU_LineIdle(bus);
+    }
+}
+
+// HAL callbacks
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    ModbusRTU_Bus *bus = ModbusRTU_FromUart(huart);
+    if (bus == NULL) {
+        return;
+    }
+
+    // TC means the last stop bit has left the shifter: t3.5 starts now.
+    // A request keeps the bus for its reply; the reply's own IDLE re-arms the
+    // timer, so the next queued frame goes out at t3.5 after the reply ends.
+    ModbusRTU_TxSlot *slot = bus->txCurrent;
+    if (slot == NULL) {
+        // Not one of ours (aborted, or a transfer started outside the queue)
+        return;
+    }
+    uint32_t holdUs = (slot->replyUs > bus->timing.t35Us) ? slot->replyUs : bus->timing.t35Us;
+
+    bus->txDoneCycles = DWT->CYCCNT;
+    slot->endCycles = bus->txDoneCycles;
+    bus->lineStats.txBusyUs += MODBUS_CYCLES_TO_US(bus->txDoneCycles - bus->txStartCycles);
+    bus->lineFreeCycles = bus->txDoneCycles;
+    bus->lineFreeValid = 1;
+
+    bus->txCompleted++;
+    slot->state = TX_SLOT_DONE;
+    bus->txCurrent = NULL;
+    bus->txActive = 0;
+    ModbusRTU_ArmSilence(bus, bus->timing.t35Us, holdUs, 0);
+}
+
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim) {
+    ModbusRTU_Bus *bus = ModbusRTU_FromTimer(htim);
+    if (bus == NULL) {
+        return;
+    }
+
+    bus->silenceT15Pos = ModbusRTU_RxDmaPos(bus);
+}
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+    ModbusRTU_Bus *bus = ModbusRTU_FromTimer(htim);
+    if (bus == NULL) {
+        return;
+    }
+
+    uint16_t pos = ModbusRTU_RxDmaPos(bus);
+    if (pos != bus->silenceRefPos) {
+        // Line became active again; its IDLE event re-arms the timer. Bytes
+        // that only started after t1.5 make the pending frame invalid.
+        if (bus->silenceCheckGap && bus->silenceT15Pos == bus->silenceRefPos) {
+            bus->rxStats.gapErrors++;
+            bus->rxDiscard = 1;
+        }
+        return;
+    }
+
+    ModbusRTU_EndFrame(bus);
+    bus->busIdle = 1;
+    ModbusRTU_KickTx(bus);
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+    ModbusRTU_Bus *bus = ModbusRTU_FromUart(huart);
+    if (bus == NULL) {
+        return;
+    }
+
+    bus->busIdle = 0;
+    ModbusRTU_Drain(bus, Size);
+    if (HAL_UARTEx_GetRxEventType(huart) == HAL_UART_RXEVENT_IDLE) {
+        ModbusRTU_LineIdle(bus);
+    }
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+    ModbusRTU_Bus *bus = ModbusRTU_FromUart(huart);
+    if (bus == NULL) {
+        return;
+    }
+
+    bus->rxStats.uartErrors++;
+    bus->rxDiscard = 1;
+
+    // ORE and DMA errors abort the reception; noise/framing errors do not
+    if (huart->RxState == HAL_UART_STATE_READY) {
+        ModbusRTU_StartRx(bus);
+    }
+
+    // A TX DMA error leaves the queue stalled; resend the current frame
+    if (bus->txActive && bus->txCurrent != NULL && huart->gState == HAL_UART_STATE_READY) {
+        ModbusRTU_StartTx(bus, bus->txCurrent);
+    }
+}
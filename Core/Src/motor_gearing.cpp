@@ -0,0 +1,249 @@
+/*
+* motor_gearing.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+#include <string.h>
+#include "motor_gearing.h"
+#include "motor_spool.h"
+#include "motor_tension.h"
+#include "modbus_motor.h"
+#include "modbus_poll.h"
+#include "modbus_rtu.h"
+
+// Bus time of one gearing cycle at GEARING_BUDGET_BAUD: the drum's FC03 of
+// the status group and the spooler's FC06, each with t3.5 after request and
+// reply and the assumed slave turnaround in between
+static constexpr uint32_t Gearing_CharUs(void) {
+    return 11U * 1000000U / GEARING_BUDGET_BAUD;
+}
+
+static constexpr uint32_t Gearing_T35Us(void) {
+    return (GEARING_BUDGET_BAUD > MODBUS_FIXED_TIMING_BAUD) ? MODBUS_T35_FIXED_US : 35U * Gearing_CharUs() / 10U;
+}
+
+static constexpr uint32_t Gearing_TransactionUs(uint32_t requestBytes, uint32_t replyBytes) {
+    return (requestBytes + replyBytes) * Gearing_CharUs() + 2U * Gearing_T35Us() + MODBUS_POLL_TURNAROUND_US;
+}
+
+static constexpr uint32_t Gearing_CycleUs(void) {
+    return Gearing_TransactionUs(8, 5 + 2 * MOTOR_STATUS_REGS) + Gearing_TransactionUs(8, 8);
+}
+
+static_assert(Gearing_CycleUs() * 100U <= GEARING_MAX_LOAD * GEARING_PERIOD_MS * 1000U,
+              "gearing cycle does not fit its share of the bus, raise GEARING_PERIOD_MS");
+
+#define GEARING_MAX_STEP_RPM     (GEARING_SLEW_RPM_S * GEARING_PERIOD_MS / 1000)
+
+static uint8_t active;
+static uint8_t spooling;      // Ratio from the spool diameter estimate
+static uint32_t changedMs;    // Last cycle the spooler setpoint moved or carried a trim
+static uint32_t spoolMs;      // Previous diameter sample
+static uint8_t drumID;
+static uint8_t spoolerID;
+static uint16_t ratioNum;
+static uint16_t ratioDen;
+static volatile uint16_t command;  // Spooler setpoint after slew limiting, read by the tension tick
+static volatile uint8_t seeded;    // 'command' starts from a polled spooler speed
+static uint16_t lastSent;
+static uint8_t handedOff;     // The tension loop has been writing the spooler speed
+static uint32_t nextMs;
+static Gearing_Stats stats;
+static Gearing_LogEntry errorLog[GEARING_LOG_SIZE];
+static uint8_t logHead;
+static uint8_t logCount;
+
+
+static uint16_t Gearing_Target(uint16_t drumRpm) {
+    if (spooling) {
+        return Spool_Target(drumRpm);
+    }
+    // Rounded to the nearest RPM
+    return (uint16_t)(((uint32_t)drumRpm * ratioNum + ratioDen / 2) / ratioDen);
+}
+
+// The speed ratio only measures the diameter when the spooler runs on the
+// untrimmed command, has had time to reach it, and both readings come from
+// about the same moment (see motor_spool.h). Anything else would feed the
+// estimate's own output, or the tension trim, back into it.
+static uint8_t Gearing_Settled(uint32_t drumTick, uint32_t spoolerTick) {
+    int32_t skew = (int32_t)(drumTick - spoolerTick);
+
+    return skew <= GEARING_SKEW_MS && skew >= -GEARING_SKEW_MS
+           && (int32_t)(spoolerTick - changedMs) >= GEARING_SETTLE_MS;
+}
+
+static void Gearing_Log(uint32_t now, uint16_t drumRpm, uint16_t spoolerRpm, uint8_t spoolerValid) {
+    Gearing_LogEntry *entry = &errorLog[logHead];
+    int32_t error = 0;
+
+    if (spoolerValid) {
+        error = (int32_t)spoolerRpm - Gearing_Target(drumRpm);
+        if (error > INT16_MAX) {
+            error = INT16_MAX;
+        } else if (error < INT16_MIN) {
+            error = INT16_MIN;
+        }
+        uint16_t magnitude = (uint16_t)((error < 0) ? -error : error);
+        stats.lastErrorRpm = (int16_t)error;
+        if (magnitude > stats.maxErrorRpm) {
+            stats.maxErrorRpm = magnitude;
+        }
+        stats.sumErrorRpm += magnitude;
+        stats.errorSamples++;
+    }
+
+    entry->tickMs = now;
+    entry->drumRpm = drumRpm;
+    entry->commandRpm = command;
+    entry->spoolerRpm = spoolerRpm;
+    entry->errorRpm = (int16_t)error;
+    entry->diameterUm = spooling ? Spool_GetDiameter() : 0;
+    logHead = (logHead + 1) % GEARING_LOG_SIZE;
+    if (logCount < GEARING_LOG_SIZE) {
+        logCount++;
+    }
+}
+
+static uint8_t Gearing_Begin(uint16_t num, uint16_t den, uint8_t spool) {
+    const Motor_Axis *drum = Motor_FindRole(MOTOR_ROLE_DRUM);
+    const Motor_Axis *spooler = Motor_FindRole(MOTOR_ROLE_SPOOLER);
+
+    if (drum == NULL || spooler == NULL || num == 0 || den == 0) {
+        return 0;
+    }
+    drumID = drum->slaveID;
+    spoolerID = spooler->slaveID;
+    ratioNum = num;
+    ratioDen = den;
+    spooling = spool;
+    handedOff = 0;
+    // Seeded by the first cycle with fresh spooler feedback
+    seeded = 0;
+    command = 0;
+    lastSent = 0;
+    memset(&stats, 0, sizeof(stats));
+    logHead = 0;
+    logCount = 0;
+    nextMs = HAL_GetTick();
+    spoolMs = nextMs;
+    active = 1;
+    return 1;
+}
+
+uint8_t Gearing_Start(uint16_t num, uint16_t den) {
+    return Gearing_Begin(num, den, 0);
+}
+
+uint8_t Gearing_StartSpool(uint32_t coreDiameterUm, uint16_t thicknessUm) {
+    if (coreDiameterUm == 0) {
+        return 0;
+    }
+    Spool_Start(coreDiameterUm, thicknessUm);
+    return Gearing_Begin(1, 1, 1);
+}
+
+void Gearing_Stop(void) {
+    // The spooler keeps its last command; stopping it is the caller's decision
+    active = 0;
+}
+
+uint8_t Gearing_Active(void) {
+    return active;
+}
+
+uint8_t Gearing_GetCommand(uint16_t *rpm) {
+    *rpm = command;
+    return seeded;
+}
+
+void Gearing_Service(void) {
+    uint32_t now = HAL_GetTick();
+    uint16_t drumRpm;
+    uint16_t spoolerRpm = 0;
+    uint32_t drumTick;
+    uint32_t spoolerTick;
+
+    if (!active || (int32_t)(now - nextMs) < 0) {
+        return;
+    }
+    // Keep the phase; a late cycle is counted, not repeated
+    if (now - nextMs >= GEARING_PERIOD_MS) {
+        stats.overruns++;
+        nextMs = now;
+    }
+    nextMs += GEARING_PERIOD_MS;
+    stats.cycles++;
+
+    if (!Motor_GetActualSpeed(drumID, &drumRpm, &drumTick) || now - drumTick > GEARING_STALE_MS) {
+        // Never steer on old data; the spooler holds its last command
+        stats.staleFeedback++;
+        return;
+    }
+    uint8_t spoolerValid = Motor_GetActualSpeed(spoolerID, &spoolerRpm, &spoolerTick)
+                           && now - spoolerTick <= GEARING_STALE_MS;
+    if (!seeded) {
+        // Bumpless: slew from wherever the spooler is running. Until the poll
+        // has seen it nothing is sent, so the recipe speed is left alone.
+        if (!spoolerValid) {
+            stats.staleFeedback++;
+            return;
+        }
+        command = spoolerRpm;
+        lastSent = spoolerRpm;
+        changedMs = now;
+        seeded = 1;
+    }
+    if (Tension_GetTrim() != 0) {
+        changedMs = now;
+    }
+
+    if (spooling) {
+        Spool_Update(now - spoolMs, drumRpm, spoolerValid ? spoolerRpm : lastSent,
+                     spoolerValid && Gearing_Settled(drumTick, spoolerTick));
+        spoolMs = now;
+    }
+
+    int32_t step = (int32_t)Gearing_Target(drumRpm) - command;
+    if (step > GEARING_MAX_STEP_RPM) {
+        step = GEARING_MAX_STEP_RPM;
+        stats.rateLimited++;
+    } else if (step < -GEARING_MAX_STEP_RPM) {
+        step = -GEARING_MAX_STEP_RPM;
+        stats.rateLimited++;
+    }
+    command = (uint16_t)(command + step);
+    if (step != 0 || handedOff) {
+        changedMs = now;
+    }
+
+    // Unchanged commands stay off the bus. While the tension loop runs it
+    // sends command + trim itself; the plain command goes out again after.
+    if (Tension_Active()) {
+        handedOff = 1;
+    } else if (command != lastSent || handedOff) {
+        Motor_SetSpeed(spoolerID, command);
+        lastSent = command;
+        handedOff = 0;
+        stats.writes++;
+    }
+    Gearing_Log(now, drumRpm, spoolerRpm, spoolerValid);
+}
+
+void Gearing_GetStats(Gearing_Stats *out) {
+    *out = stats;
+}
+
+uint8_t Gearing_ReadLog(Gearing_LogEntry *entries, uint8_t max) {
+    uint8_t n = (logCount < max) ? logCount : max;
+    uint8_t first = (uint8_t)((logHead + GEARING_LOG_SIZE - logCount) % GEARING_LOG_SIZE);
+
+    // The newest 'n' entries, oldest of those first
+    first = (uint8_t)((first + logCount - n) % GEARING_LOG_SIZE);
+    for (uint8_t i = 0; i < n; i++) {
+        entries[i] = errorLog[(first + i) % GEARING_LOG_SIZE];
+    }
+    return n;
+}
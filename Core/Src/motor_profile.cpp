@@ -0,0 +1,271 @@
+/*
+* motor_profile.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+#include <string.h>
+#include "motor_profile.h"
+#include "modbus_master.h"
+#include "modbus_motor.h"
+#include "modbus_regmap.h"
+
+// Speeds are held in milli-RPM so a slow ramp still moves between ticks.
+// Within a segment v(t) = v0 + dv * t / linDen + dv * t^2 / quadDen, t in ticks.
+typedef struct {
+    uint32_t ticks;
+    int32_t v0;
+    int32_t linDen;           // 0 for no linear term
+    int32_t quadDen;          // Negative while jerk brings the acceleration back down, 0 for none
+} Profile_Segment;
+
+typedef struct {
+    uint8_t slaveID;
+    uint8_t bus;
+    int32_t dv;               // Whole move, milli-RPM
+    uint16_t target;
+    uint16_t lastSent;
+    Profile_Segment segment[PROFILE_SEGMENTS];
+} Profile_Axis;
+
+static Profile_Axis axes[PROFILE_MAX_AXES];
+static uint8_t axisCount;
+static uint32_t tick;
+static uint32_t totalTicks;
+static volatile uint8_t running;
+static Profile_Stats stats;
+
+
+static uint32_t Profile_Sqrt(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static uint32_t Profile_Ticks(uint64_t ms) {
+    return (uint32_t)((ms + PROFILE_TICK_MS - 1) / PROFILE_TICK_MS);
+}
+
+// Shortest jerk and constant-acceleration phases for a speed change of dv RPM
+static void Profile_MinPhases(uint32_t dv, uint32_t accel, uint32_t *tj, uint32_t *ta) {
+    *tj = 0;
+    *ta = 0;
+    if (dv == 0) {
+        return;
+    }
+    if ((uint64_t)dv * PROFILE_JERK_RPM_S2 >= (uint64_t)accel * accel) {
+        // Reaches the acceleration limit and holds it
+        *tj = Profile_Ticks((uint64_t)accel * 1000 / PROFILE_JERK_RPM_S2);
+        uint64_t rampMs = (uint64_t)dv * 1000 / accel;
+        uint64_t jerkMs = (uint64_t)accel * 1000 / PROFILE_JERK_RPM_S2;
+        *ta = (rampMs > jerkMs) ? Profile_Ticks(rampMs - jerkMs) : 0;
+    } else {
+        // Too small a change to reach it: jerk up, then straight back down
+        *tj = Profile_Ticks(Profile_Sqrt((uint64_t)dv * 1000000 / PROFILE_JERK_RPM_S2));
+    }
+    if (*tj == 0) {
+        *tj = 1;
+    }
+}
+
+static void Profile_Build(Profile_Axis *axis, int32_t start, uint32_t tj, uint32_t ta) {
+    Profile_Segment *s = axis->segment;
+    int32_t dv = axis->dv;
+    int32_t span = (int32_t)(tj + ta);
+
+    memset(s, 0, sizeof(axis->segment));
+    if (tj == 0) {
+        // No change: hold the start speed for the whole move
+        for (uint8_t k = 0; k < PROFILE_SEGMENTS; k++) {
+            s[k].v0 = start;
+        }
+        return;
+    }
+    s[0].ticks = tj;
+    s[0].v0 = start;
+    s[0].quadDen = 2 * (int32_t)tj * span;
+
+    s[1].ticks = ta;
+    s[1].v0 = s[0].v0 + (int32_t)((int64_t)dv * tj / (2 * span));
+    s[1].linDen = span;
+
+    s[2].ticks = tj;
+    s[2].v0 = s[1].v0 + (int32_t)((int64_t)dv * ta / span);
+    s[2].linDen = span;
+    s[2].quadDen = -s[0].quadDen;
+}
+
+static uint16_t Profile_Evaluate(const Profile_Axis *axis, uint32_t t) {
+    const Profile_Segment *s = axis->segment;
+    uint8_t k = 0;
+
+    while (k < PROFILE_SEGMENTS - 1 && t > s[k].ticks) {
+        t -= s[k].ticks;
+        k++;
+    }
+    int64_t v = s[k].v0;
+    if (s[k].linDen != 0) {
+        v += (int64_t)axis->dv * t / s[k].linDen;
+    }
+    if (s[k].quadDen != 0) {
+        v += (int64_t)axis->dv * t * t / s[k].quadDen;
+    }
+    v = (v + 500) / 1000;
+    return (uint16_t)((v < 0) ? 0 : ((v > 0xFFFF) ? 0xFFFF : v));
+}
+
+static uint16_t Profile_StartSpeed(uint8_t slaveID) {
+    uint16_t rpm;
+    uint32_t tickMs;
+
+    // Continue from our own last setpoint when retargeting, the drive's
+    // measured speed otherwise
+    for (uint8_t i = 0; i < axisCount; i++) {
+        if (axes[i].slaveID == slaveID) {
+            return axes[i].lastSent;
+        }
+    }
+    return Motor_GetActualSpeed(slaveID, &rpm, &tickMs) ? rpm : 0;
+}
+
+uint8_t Profile_Move(const Profile_Target *targets, uint8_t count) {
+    Profile_Axis next[PROFILE_MAX_AXES];
+    uint32_t tj[PROFILE_MAX_AXES];
+    uint32_t ta[PROFILE_MAX_AXES];
+    uint32_t total = 0;
+
+    if (count == 0 || count > PROFILE_MAX_AXES) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (Motor_FindAxis(targets[i].slaveID) == NULL) {
+            return 0;
+        }
+    }
+    // Freeze the current move so its last setpoints are a stable starting point
+    running = 0;
+
+    // Shortest move per axis within its acceleration and the jerk limit
+    for (uint8_t i = 0; i < count; i++) {
+        const Motor_Axis *axis = Motor_FindAxis(targets[i].slaveID);
+        uint16_t start = Profile_StartSpeed(targets[i].slaveID);
+        uint16_t target = (uint16_t)Motor_Register<MOTOR_REG_SPEED>::Encode(targets[i].rpm);
+        uint32_t accel = (axis->acceleration != 0) ? axis->acceleration
+                                                   : (uint32_t)Motor_Register<MOTOR_REG_ACCELERATION>::max;
+
+        next[i].slaveID = axis->slaveID;
+        next[i].bus = axis->bus;
+        next[i].dv = ((int32_t)target - start) * 1000;
+        next[i].target = target;
+        next[i].lastSent = start;
+        Profile_MinPhases((target > start) ? target - start : start - target, accel, &tj[i], &ta[i]);
+        next[i].segment[0].v0 = (int32_t)start * 1000;
+        if (2 * tj[i] + ta[i] > total) {
+            total = 2 * tj[i] + ta[i];
+        }
+    }
+
+    // Stretch every axis to the slowest one. Scaling both phases by the same
+    // factor lowers acceleration and jerk, so no limit is exceeded.
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t own = 2 * tj[i] + ta[i];
+        if (own != 0 && own != total) {
+            tj[i] = (tj[i] * total + own / 2) / own;
+            if (tj[i] == 0) {
+                tj[i] = 1;
+            }
+            if (2 * tj[i] > total) {
+                tj[i] = total / 2;
+            }
+            ta[i] = total - 2 * tj[i];
+        }
+        Profile_Build(&next[i], next[i].segment[0].v0, tj[i], ta[i]);
+    }
+
+    // The drive's own ramp would fight the stream, so open it fully. Streamed
+    // setpoints never reach the shadow, so whatever it holds for them goes now.
+    for (uint8_t i = 0; i < count; i++) {
+        Modbus_ShadowInvalidate(next[i].bus, next[i].slaveID);
+        Motor_SetAcceleration(next[i].slaveID, Motor_Register<MOTOR_REG_ACCELERATION>::max);
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(axes, next, count * sizeof(next[0]));
+    axisCount = count;
+    tick = 0;
+    totalTicks = total;
+    stats.moves++;
+    stats.lastTicks = total;
+    running = 1;
+    __set_PRIMASK(primask);
+    return 1;
+}
+
+void Profile_Abort(void) {
+    // Drives keep the last setpoint they received
+    running = 0;
+}
+
+uint8_t Profile_Busy(void) {
+    return running;
+}
+
+void Profile_GetStats(Profile_Stats *out) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *out = stats;
+    __set_PRIMASK(primask);
+}
+
+void Profile_TimerTick(void) {
+    uint32_t start = DWT->CYCCNT;
+    uint8_t pending = 0;
+
+    if (!running) {
+        return;
+    }
+    tick++;
+    stats.ticks++;
+
+    for (uint8_t i = 0; i < axisCount; i++) {
+        Profile_Axis *axis = &axes[i];
+        uint16_t rpm = (tick >= totalTicks) ? axis->target : Profile_Evaluate(axis, tick);
+        if (rpm == axis->lastSent) {
+            continue;
+        }
+
+        Modbus_Request request = { axis->slaveID, MODBUS_WRITE_SINGLE_REG, Motor_Register<MOTOR_REG_SPEED>::address,
+                                   rpm, NULL, MODBUS_PRIO_CONTROL, axis->bus, 0, 0 };
+        if (Modbus_QueueStream(&request) == HAL_OK) {
+            axis->lastSent = rpm;
+            stats.setpoints++;
+        } else {
+            // Retried on the next tick with whatever the profile says then
+            stats.dropped++;
+            pending = 1;
+        }
+    }
+    if (tick >= totalTicks && !pending) {
+        running = 0;
+    }
+
+    stats.lastTickCycles = DWT->CYCCNT - start;
+    if (stats.lastTickCycles > stats.maxTickCycles) {
+        stats.maxTickCycles = stats.lastTickCycles;
+    }
+}
@@ -0,0 +1,78 @@
+/*
+* motor_spool.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+#include <string.h>
+#include "motor_spool.h"
+
+static uint32_t coreDiameter;
+static uint32_t diameter;
+static uint16_t thickness;
+static uint32_t growthRemainder;  // rpm x ms x um, below one micrometre of diameter
+static uint32_t revRemainder;     // rpm x ms, below one milli-revolution
+static Spool_Stats stats;
+
+
+void Spool_Start(uint32_t coreDiameterUm, uint16_t thicknessUm) {
+    coreDiameter = (coreDiameterUm > SPOOL_MAX_DIAMETER_UM) ? SPOOL_MAX_DIAMETER_UM : coreDiameterUm;
+    diameter = coreDiameter;
+    thickness = thicknessUm;
+    growthRemainder = 0;
+    revRemainder = 0;
+    memset(&stats, 0, sizeof(stats));
+    stats.diameterUm = diameter;
+}
+
+void Spool_Update(uint32_t dtMs, uint16_t drumRpm, uint16_t spoolerRpm, uint8_t measured) {
+    int64_t next = diameter;
+
+    stats.samples++;
+
+    // Prediction: rpm x ms / 60000 revolutions, two thicknesses each. The
+    // remainders carry the fractions so slow spooling still grows the estimate.
+    uint64_t turns = (uint64_t)spoolerRpm * dtMs;
+    uint64_t growth = growthRemainder + turns * 2U * thickness;
+    next += (int64_t)(growth / 60000U);
+    growthRemainder = (uint32_t)(growth % 60000U);
+    uint64_t revs = revRemainder + turns;
+    stats.milliRevs += (uint32_t)(revs / 60U);
+    revRemainder = (uint32_t)(revs % 60U);
+
+    // Correction from the speed ratio
+    if (measured && drumRpm >= SPOOL_MEASURE_MIN_RPM && spoolerRpm >= SPOOL_MEASURE_MIN_RPM) {
+        uint32_t implied = (uint32_t)(((uint64_t)SPOOL_DRUM_DIAMETER_UM * drumRpm + spoolerRpm / 2U) / spoolerRpm);
+        next += ((int64_t)implied - next) / (1 << SPOOL_MEASURE_SHIFT);
+        stats.lastMeasuredUm = implied;
+        stats.corrections++;
+    }
+
+    if (next < coreDiameter) {
+        next = coreDiameter;
+        stats.clamped++;
+    } else if (next > SPOOL_MAX_DIAMETER_UM) {
+        next = SPOOL_MAX_DIAMETER_UM;
+        stats.clamped++;
+    }
+    diameter = (uint32_t)next;
+    stats.diameterUm = diameter;
+}
+
+uint32_t Spool_GetDiameter(void) {
+    return diameter;
+}
+
+uint16_t Spool_Target(uint16_t drumRpm) {
+    if (diameter == 0) {
+        return 0;
+    }
+    // Rounded to the nearest RPM
+    uint64_t rpm = ((uint64_t)drumRpm * SPOOL_DRUM_DIAMETER_UM + diameter / 2U) / diameter;
+    return (uint16_t)((rpm > 0xFFFF) ? 0xFFFF : rpm);
+}
+
+void Spool_GetStats(Spool_Stats *out) {
+    *out = stats;
+}
@@ -0,0 +1,179 @@
+/*
+* motor_tension.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+#include <string.h>
+#include "motor_tension.h"
+#include "motor_gearing.h"
+#include "modbus_master.h"
+#include "modbus_motor.h"
+#include "modbus_regmap.h"
+
+static_assert(TENSION_PERIOD_MS >= MOTOR_STATUS_PERIOD_MS, "tension loop would run on repeated load readings");
+static_assert(TENSION_SETPOINT_LOAD < M2_TORQUE_LIMIT, "tension setpoint at or above the spooler torque limit");
+
+#define TENSION_LIMIT_Q8         ((int32_t)TENSION_MAX_TRIM_RPM * 256)
+
+static volatile uint8_t active;
+static uint8_t spoolerID;
+static uint8_t spoolerBus;
+static uint16_t setpoint;
+static uint16_t baseRpm;      // Used when gearing is not running
+static uint8_t baseValid;     // baseRpm comes from a polled spooler speed
+static int32_t integral;      // Q8 RPM
+static uint16_t lastSent;
+static uint8_t timed;         // lastEntry holds a previous tick
+static uint32_t lastEntry;
+static Tension_Stats stats;
+
+
+// Untrimmed spooler speed: the gearing command, or without gearing the speed
+// first polled after start. Nothing is trimmed until one of them is known.
+static uint8_t Tension_Base(uint16_t *rpm) {
+    uint32_t tickMs;
+
+    if (Gearing_Active()) {
+        return Gearing_GetCommand(rpm);
+    }
+    if (!baseValid && Motor_GetActualSpeed(spoolerID, &baseRpm, &tickMs)) {
+        baseValid = 1;
+    }
+    *rpm = baseRpm;
+    return baseValid;
+}
+
+uint8_t Tension_Start(uint16_t load) {
+    const Motor_Axis *spooler = Motor_FindRole(MOTOR_ROLE_SPOOLER);
+    uint16_t rpm;
+
+    if (spooler == NULL || load >= spooler->torqueLimit) {
+        return 0;
+    }
+    active = 0;
+    spoolerID = spooler->slaveID;
+    spoolerBus = spooler->bus;
+    setpoint = load;
+    baseValid = 0;
+    lastSent = Tension_Base(&rpm) ? rpm : 0;
+    integral = 0;
+    timed = 0;
+    memset(&stats, 0, sizeof(stats));
+    // Trimmed setpoints never reach the shadow
+    Modbus_ShadowInvalidate(spoolerBus, spoolerID);
+    active = 1;
+    return 1;
+}
+
+void Tension_Stop(void) {
+    // The spooler keeps its last trimmed setpoint until gearing writes again
+    active = 0;
+    Modbus_ShadowInvalidate(spoolerBus, spoolerID);
+}
+
+uint8_t Tension_Active(void) {
+    return active;
+}
+
+int16_t Tension_GetTrim(void) {
+    return active ? stats.lastTrimRpm : 0;
+}
+
+void Tension_GetStats(Tension_Stats *out) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *out = stats;
+    __set_PRIMASK(primask);
+}
+
+// PI in Q8 RPM with the integrator held inside the trim limit, and not moved
+// further into saturation, so it never winds up
+static int16_t Tension_Control(int32_t error) {
+    int32_t p = TENSION_KP_Q8 * error;
+    int32_t next = integral + TENSION_KI_Q8 * error;
+
+    if (next > TENSION_LIMIT_Q8) {
+        next = TENSION_LIMIT_Q8;
+    } else if (next < -TENSION_LIMIT_Q8) {
+        next = -TENSION_LIMIT_Q8;
+    }
+    int32_t out = p + next;
+    if (out > TENSION_LIMIT_Q8) {
+        out = TENSION_LIMIT_Q8;
+        stats.saturated++;
+        if (error < 0) {
+            integral = next;
+        }
+    } else if (out < -TENSION_LIMIT_Q8) {
+        out = -TENSION_LIMIT_Q8;
+        stats.saturated++;
+        if (error > 0) {
+            integral = next;
+        }
+    } else {
+        integral = next;
+    }
+    return (int16_t)((out + ((out < 0) ? -128 : 128)) / 256);
+}
+
+void Tension_TimerTick(void) {
+    uint32_t start = DWT->CYCCNT;
+    uint16_t load;
+    uint32_t tickMs;
+
+    if (!active) {
+        timed = 0;
+        return;
+    }
+    // Period and jitter from the ISR entry times
+    if (timed) {
+        uint32_t nominal = SystemCoreClock / 1000U * TENSION_PERIOD_MS;
+        uint32_t period = start - lastEntry;
+        uint32_t jitter = (period > nominal) ? period - nominal : nominal - period;
+        stats.lastPeriodCycles = period;
+        stats.lastJitterCycles = jitter;
+        if (jitter > stats.maxJitterCycles) {
+            stats.maxJitterCycles = jitter;
+        }
+        stats.sumJitterCycles += jitter;
+        stats.jitterSamples++;
+    }
+    lastEntry = start;
+    timed = 1;
+    stats.cycles++;
+
+    if (!Motor_GetLoad(spoolerID, &load, &tickMs) || HAL_GetTick() - tickMs > TENSION_STALE_MS) {
+        // Never steer on old data; trim and integrator hold
+        stats.staleFeedback++;
+    } else {
+        // Too little load means too little tension: wind faster
+        int32_t error = (int32_t)setpoint - load;
+        stats.lastErrorLoad = (int16_t)error;
+        stats.lastTrimRpm = Tension_Control(error);
+    }
+
+    uint16_t base;
+    if (!Tension_Base(&base)) {
+        stats.noBase++;
+    } else {
+        uint16_t rpm = (uint16_t)Motor_Register<MOTOR_REG_SPEED>::Encode((int32_t)base + stats.lastTrimRpm);
+        if (rpm != lastSent) {
+            Modbus_Request request = { spoolerID, MODBUS_WRITE_SINGLE_REG, Motor_Register<MOTOR_REG_SPEED>::address,
+                                       rpm, NULL, MODBUS_PRIO_CONTROL, spoolerBus, 0, 0 };
+            if (Modbus_QueueStream(&request) == HAL_OK) {
+                lastSent = rpm;
+                stats.writes++;
+            } else {
+                // Retried next cycle
+                stats.dropped++;
+            }
+        }
+    }
+
+    stats.lastExecCycles = DWT->CYCCNT - start;
+    if (stats.lastExecCycles > stats.maxExecCycles) {
+        stats.maxExecCycles = stats.lastExecCycles;
+    }
+}
@@ -6,7 +6,15 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
 ../Core/Src/main.cpp \
-../Core/Src/modbus_motor.cpp 
+../Core/Src/modbus_motor.cpp \
+../Core/Src/modbus_rtu.cpp \
+../Core/Src/modbus_crc.cpp \
+../Core/Src/modbus_master.cpp \
+../Core/Src/modbus_poll.cpp \
+../Core/Src/motor_gearing.cpp \
+../Core/Src/motor_profile.cpp \
+../Core/Src/motor_spool.cpp \
+../Core/Src/motor_tension.cpp 
 
 C_SRCS += \
 ../Core/Src/stm32f4xx_hal_msp.c \
@@ -25,6 +33,14 @@ C_DEPS += \
 OBJS += \
 ./Core/Src/main.o \
 ./Core/Src/modbus_motor.o \
+./Core/Src/modbus_rtu.o \
+./Core/Src/modbus_crc.o \
+./Core/Src/modbus_master.o \
+./Core/Src/modbus_poll.o \
+./Core/Src/motor_gearing.o \
+./Core/Src/motor_profile.o \
+./Core/Src/motor_spool.o \
+./Core/Src/motor_tension.o \
 ./Core/Src/stm32f4xx_hal_msp.o \
 ./Core/Src/stm32f4xx_it.o \
 ./Core/Src/syscalls.o \
@@ -33,7 +49,15 @@ OBJS += \
 
 CPP_DEPS += \
 ./Core/Src/main.d \
-./Core/Src/modbus_motor.d 
+./Core/Src/modbus_motor.d \
+./Core/Src/modbus_rtu.d \
+./Core/Src/modbus_crc.d \
+./Core/Src/modbus_master.d \
+./Core/Src/modbus_poll.d \
+./Core/Src/motor_gearing.d \
+./Core/Src/motor_profile.d \
+./Core/Src/motor_spool.d \
+./Core/Src/motor_tension.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -45,7 +69,7 @@ Core/Src/%.o Core/Src/%.su Core/Src/%.cyclo: ../Core/Src/%.c Core/Src/subdir.mk
 clean: clean-Core-2f-Src
 
 clean-Core-2f-Src:
-	-$(RM) ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/modbus_motor.cyclo ./Core/Src/modbus_motor.d ./Core/Src/modbus_motor.o ./Core/Src/modbus_motor.su ./Core/Src/stm32f4xx_hal_msp.cyclo ./Core/Src/stm32f4xx_hal_msp.d ./Core/Src/stm32f4xx_hal_msp.o ./Core/Src/stm32f4xx_hal_msp.su ./Core/Src/stm32f4xx_it.cyclo ./Core/Src/stm32f4xx_it.d ./Core/Src/stm32f4xx_it.o ./Core/Src/stm32f4xx_it.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32f4xx.cyclo ./Core/Src/system_stm32f4xx.d ./Core/Src/system_stm32f4xx.o ./Core/Src/system_stm32f4xx.su
+	-$(RM) ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/modbus_motor.cyclo ./Core/Src/modbus_motor.d ./Core/Src/modbus_motor.o ./Core/Src/modbus_motor.su ./Core/Src/modbus_rtu.cyclo ./Core/Src/modbus_rtu.d ./Core/Src/modbus_rtu.o ./Core/Src/modbus_rtu.su ./Core/Src/modbus_crc.cyclo ./Core/Src/modbus_crc.d ./Core/Src/modbus_crc.o ./Core/Src/modbus_crc.su ./Core/Src/modbus_master.cyclo ./Core/Src/modbus_master.d ./Core/Src/modbus_master.o ./Core/Src/modbus_master.su ./Core/Src/modbus_poll.cyclo ./Core/Src/modbus_poll.d ./Core/Src/modbus_poll.o ./Core/Src/modbus_poll.su ./Core/Src/motor_gearing.cyclo ./Core/Src/motor_gearing.d ./Core/Src/motor_gearing.o ./Core/Src/motor_gearing.su ./Core/Src/motor_profile.cyclo ./Core/Src/motor_profile.d ./Core/Src/motor_profile.o ./Core/Src/motor_profile.su ./Core/Src/motor_spool.cyclo ./Core/Src/motor_spool.d ./Core/Src/motor_spool.o ./Core/Src/motor_spool.su ./Core/Src/motor_tension.cyclo ./Core/Src/motor_tension.d ./Core/Src/motor_tension.o ./Core/Src/motor_tension.su ./Core/Src/stm32f4xx_hal_msp.cyclo ./Core/Src/stm32f4xx_hal_msp.d ./Core/Src/stm32f4xx_hal_msp.o ./Core/Src/stm32f4xx_hal_msp.su ./Core/Src/stm32f4xx_it.cyclo ./Core/Src/stm32f4xx_it.d ./Core/Src/stm32f4xx_it.o ./Core/Src/stm32f4xx_it.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32f4xx.cyclo ./Core/Src/system_stm32f4xx.d ./Core/Src/system_stm32f4xx.o ./Core/Src/system_stm32f4xx.su
 
 .PHONY: clean-Core-2f-Src
 
@@ -0,0 +1,73 @@
+/*
+* bench_modbus_crc.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "modbus_crc.h"
+
+// Host timings rank the backends but do not carry over to the Cortex-M4,
+// whose flash wait states and lack of a data cache change the balance;
+// re-measure on target before changing MODBUS_CRC_BACKEND.
+#define BENCH_BYTES              (64UL * 1024 * 1024)  // Processed per backend and frame length
+
+typedef uint16_t (*Bench_Backend)(uint16_t crc, const uint8_t *buffer, uint16_t length);
+
+typedef struct {
+    const char *name;
+    Bench_Backend update;
+} Bench_Entry;
+
+static const Bench_Entry backends[] = {
+    { "bitwise", ModbusCRC_UpdateBitwise },
+    { "nibble",  ModbusCRC_UpdateNibble },
+    { "table",   ModbusCRC_UpdateTable },
+    { "slice4",  ModbusCRC_UpdateSlice4 },
+};
+
+// Typical FC06 request, a 10-register read reply and the largest RTU frame
+static const uint16_t lengths[] = { 6, 25, 254 };
+
+static uint8_t buffer[256];
+static volatile uint16_t sink;
+
+
+static double Bench_Now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+int main(void) {
+    for (uint16_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = (uint8_t)(i * 7 + 1);
+    }
+
+    printf("%-8s", "bytes");
+    for (const Bench_Entry &backend : backends) {
+        printf("%12s", backend.name);
+    }
+    printf("   (ns per byte)\n");
+
+    for (uint16_t length : lengths) {
+        printf("%-8u", length);
+        for (const Bench_Entry &backend : backends) {
+            uint32_t frames = (uint32_t)(BENCH_BYTES / length);
+            uint16_t crc = MODBUS_CRC_INIT;
+            double start = Bench_Now();
+            for (uint32_t n = 0; n < frames; n++) {
+                // Chained so the calls cannot be hoisted out of the loop
+                crc = backend.update(crc, buffer, length);
+            }
+            double elapsed = Bench_Now() - start;
+            sink = crc;
+            printf("%12.3f", elapsed * 1e9 / ((double)frames * length));
+        }
+        printf("\n");
+    }
+    return 0;
+}
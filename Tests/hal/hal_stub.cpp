@@ -0,0 +1,158 @@
+/*
+* hal_stub.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+#include <string.h>
+#include "hal_stub.h"
+#include "modbus_rtu.h"
+
+#define HAL_STUB_PCLK            96000000U
+
+USART_TypeDef halStubUsart[3] = { { 1 }, { 2 }, { 6 } };
+DWT_Type halStubDwt;
+CoreDebug_Type halStubCoreDebug;
+uint32_t SystemCoreClock = HAL_STUB_PCLK;
+
+static uint32_t primask;
+static uint32_t tick;
+static HalStub_Port *ports[MODBUS_BUS_COUNT];
+static uint8_t portCount;
+
+
+uint32_t __get_PRIMASK(void) {
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t priMask) {
+    primask = priMask;
+}
+
+void __disable_irq(void) {
+    primask = 1;
+}
+
+void __enable_irq(void) {
+    primask = 0;
+}
+
+void __DMB(void) {
+}
+
+uint32_t HAL_GetTick(void) {
+    // Busy-wait loops on the tick must end on the host as well
+    return tick++;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) {
+    return HAL_STUB_PCLK;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void) {
+    return HAL_STUB_PCLK;
+}
+
+void Error_Handler(void) {
+}
+
+static HalStub_Port *HalStub_Find(UART_HandleTypeDef *huart) {
+    for (uint8_t i = 0; i < portCount; i++) {
+        if (&ports[i]->huart == huart) {
+            return ports[i];
+        }
+    }
+    return NULL;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart) {
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size) {
+    HalStub_Port *port = HalStub_Find(huart);
+
+    if (port == NULL || port->txBusy) {
+        return HAL_BUSY;
+    }
+    if (port->txRefuse != 0) {
+        port->txRefuse--;
+        return HAL_ERROR;
+    }
+    if (port->txCount < HAL_STUB_MAX_TX) {
+        HalStub_Tx *tx = &port->tx[port->txCount];
+        tx->length = Size;
+        memcpy(tx->data, pData, Size);
+    }
+    port->txCount++;
+    port->txBusy = 1;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+    (void)pData;
+    huart->hdmarx->counter = Size;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    huart->itSources |= UART_IT_IDLE;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart) {
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+uint32_t HAL_UARTEx_GetRxEventType(UART_HandleTypeDef *huart) {
+    return huart->RxEventType;
+}
+
+void HalStub_InitPort(HalStub_Port *port, USART_TypeDef *instance, uint32_t baud) {
+    memset(port, 0, sizeof(*port));
+    port->huart.Instance = instance;
+    port->huart.Init.BaudRate = baud;
+    port->huart.Init.WordLength = UART_WORDLENGTH_8B;
+    port->huart.Init.StopBits = UART_STOPBITS_1;
+    port->huart.Init.OverSampling = UART_OVERSAMPLING_16;
+    port->huart.hdmarx = &port->hdmarx;
+    port->huart.gState = HAL_UART_STATE_READY;
+    if (portCount < MODBUS_BUS_COUNT) {
+        ports[portCount++] = port;
+    }
+}
+
+void HalStub_CompleteTx(HalStub_Port *port) {
+    UART_HandleTypeDef *huart = &port->huart;
+
+    // The USART IRQ sees TC first (DE release), then HAL reports completion
+    huart->flags |= UART_FLAG_TC;
+    huart->itSources |= UART_IT_TC;
+    ModbusRTU_IRQHandler(huart);
+    huart->flags &= ~UART_FLAG_TC;
+    huart->itSources &= ~UART_IT_TC;
+
+    port->txBusy = 0;
+    huart->gState = HAL_UART_STATE_READY;
+    HAL_UART_TxCpltCallback(huart);
+}
+
+void HalStub_ExpireSilence(HalStub_Port *port) {
+    TIM_HandleTypeDef *htim = &port->htim;
+
+    // The silence timers count microseconds: CC1 at t1.5, update at the hold
+    HalStub_AdvanceCycles(htim->compare1 * HAL_STUB_CYCLES_PER_US);
+    HAL_TIM_OC_DelayElapsedCallback(htim);
+    HalStub_AdvanceCycles((htim->autoReload - htim->compare1) * HAL_STUB_CYCLES_PER_US);
+    HAL_TIM_PeriodElapsedCallback(htim);
+}
+
+void HalStub_AdvanceCycles(uint32_t cycles) {
+    halStubDwt.CYCCNT += cycles;
+}
+
+uint8_t HalStub_IrqMasked(void) {
+    return (uint8_t)primask;
+}
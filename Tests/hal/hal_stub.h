@@ -0,0 +1,47 @@
+
+
+#ifndef HAL_STUB_H
+#define HAL_STUB_H
+
+/*
+ * hal_stub.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdint.h>
+#include "stm32f4xx_hal.h"
+
+#define HAL_STUB_MAX_TX          32     // Transmissions remembered per UART
+#define HAL_STUB_CYCLES_PER_US   96U    // DWT cycles per microsecond at 96 MHz
+
+// One HAL_UART_Transmit_DMA call, copied when it was made
+typedef struct {
+    uint16_t length;
+    uint8_t data[256];
+} HalStub_Tx;
+
+typedef struct {
+    UART_HandleTypeDef huart;
+    DMA_HandleTypeDef hdmarx;
+    TIM_HandleTypeDef htim;
+    GPIO_TypeDef de;
+    HalStub_Tx tx[HAL_STUB_MAX_TX];
+    uint8_t txCount;
+    uint8_t txBusy;           // A transfer was started and not yet completed
+    uint8_t txRefuse;         // HAL_UART_Transmit_DMA calls still to fail with HAL_ERROR
+} HalStub_Port;
+
+// Fresh UART/DMA/timer handles for one bus at 'baud', 8N1
+void HalStub_InitPort(HalStub_Port *port, USART_TypeDef *instance, uint32_t baud);
+// The last stop bit of the transfer in flight has left: TC interrupt, then
+// the HAL TX complete callback
+void HalStub_CompleteTx(HalStub_Port *port);
+// The port's silence timer ran out with no new bytes on the line; the
+// cycle counter moves on by the armed period
+void HalStub_ExpireSilence(HalStub_Port *port);
+void HalStub_AdvanceCycles(uint32_t cycles);
+uint8_t HalStub_IrqMasked(void);
+
+#endif  // HAL_STUB_H
@@ -0,0 +1,179 @@
+
+
+#ifndef STM32F4XX_HAL_H
+#define STM32F4XX_HAL_H
+
+/*
+ * stm32f4xx_hal.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+// Host stand-in for the STM32F4 HAL: only what the Modbus sources in Core/
+// touch. Peripherals are plain structs the tests drive by hand, interrupt
+// masking is a flag and DWT->CYCCNT is a counter the tests advance.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+#define GPIO_PIN_0               ((uint16_t)0x0001)
+#define GPIO_PIN_4               ((uint16_t)0x0010)
+#define GPIO_PIN_8               ((uint16_t)0x0100)
+
+typedef struct {
+    volatile uint32_t IDR;
+    volatile uint32_t BSRR;   // Writes are applied to IDR by HalStub_ApplyGpio
+} GPIO_TypeDef;
+
+typedef struct {
+    uint32_t id;
+} USART_TypeDef;
+
+extern USART_TypeDef halStubUsart[3];
+#define USART1                   (&halStubUsart[0])
+#define USART2                   (&halStubUsart[1])
+#define USART6                   (&halStubUsart[2])
+
+typedef struct {
+    uint32_t counter;         // Remaining transfers, like NDTR
+} DMA_HandleTypeDef;
+
+#define __HAL_DMA_GET_COUNTER(h) ((h)->counter)
+
+#define UART_WORDLENGTH_8B       0x00000000U
+#define UART_WORDLENGTH_9B       0x00001000U
+#define UART_STOPBITS_1          0x00000000U
+#define UART_STOPBITS_2          0x00002000U
+#define UART_OVERSAMPLING_16     0x00000000U
+#define UART_OVERSAMPLING_8      0x00008000U
+
+#define UART_DIV_SAMPLING16(_PCLK_, _BAUD_)   ((uint32_t)((((uint64_t)(_PCLK_)) * 25U) / (4U * ((uint64_t)(_BAUD_)))))
+#define UART_DIVMANT_SAMPLING16(_PCLK_, _BAUD_) (UART_DIV_SAMPLING16((_PCLK_), (_BAUD_)) / 100U)
+#define UART_DIVFRAQ_SAMPLING16(_PCLK_, _BAUD_) ((((UART_DIV_SAMPLING16((_PCLK_), (_BAUD_)) - (UART_DIVMANT_SAMPLING16((_PCLK_), (_BAUD_)) * 100U)) * 16U) + 50U) / 100U)
+#define UART_BRR_SAMPLING16(_PCLK_, _BAUD_)   ((UART_DIVMANT_SAMPLING16((_PCLK_), (_BAUD_)) << 4U) + \
+                                               (UART_DIVFRAQ_SAMPLING16((_PCLK_), (_BAUD_)) & 0xF0U) + \
+                                               (UART_DIVFRAQ_SAMPLING16((_PCLK_), (_BAUD_)) & 0x0FU))
+#define UART_DIV_SAMPLING8(_PCLK_, _BAUD_)    ((uint32_t)((((uint64_t)(_PCLK_)) * 25U) / (2U * ((uint64_t)(_BAUD_)))))
+#define UART_DIVMANT_SAMPLING8(_PCLK_, _BAUD_) (UART_DIV_SAMPLING8((_PCLK_), (_BAUD_)) / 100U)
+#define UART_DIVFRAQ_SAMPLING8(_PCLK_, _BAUD_) ((((UART_DIV_SAMPLING8((_PCLK_), (_BAUD_)) - (UART_DIVMANT_SAMPLING8((_PCLK_), (_BAUD_)) * 100U)) * 8U) + 50U) / 100U)
+#define UART_BRR_SAMPLING8(_PCLK_, _BAUD_)    ((UART_DIVMANT_SAMPLING8((_PCLK_), (_BAUD_)) << 4U) + \
+                                               ((UART_DIVFRAQ_SAMPLING8((_PCLK_), (_BAUD_)) & 0xF8U) << 1U) + \
+                                               (UART_DIVFRAQ_SAMPLING8((_PCLK_), (_BAUD_)) & 0x07U))
+
+typedef struct {
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef enum {
+    HAL_UART_STATE_RESET = 0x00U,
+    HAL_UART_STATE_READY = 0x20U,
+    HAL_UART_STATE_BUSY_TX = 0x21U,
+    HAL_UART_STATE_BUSY_RX = 0x22U
+} HAL_UART_StateTypeDef;
+
+#define HAL_UART_RXEVENT_TC      0x00000000U
+#define HAL_UART_RXEVENT_HT      0x00000001U
+#define HAL_UART_RXEVENT_IDLE    0x00000002U
+
+#define UART_FLAG_TC             0x00000040U
+#define UART_FLAG_IDLE           0x00000010U
+#define UART_IT_TC               0x00000040U
+#define UART_IT_IDLE             0x00000010U
+
+typedef struct {
+    USART_TypeDef *Instance;
+    UART_InitTypeDef Init;
+    DMA_HandleTypeDef *hdmarx;
+    volatile HAL_UART_StateTypeDef gState;
+    volatile HAL_UART_StateTypeDef RxState;
+    uint32_t RxEventType;
+    uint32_t flags;           // UART_FLAG_* currently raised
+    uint32_t itSources;       // UART_IT_* currently enabled
+} UART_HandleTypeDef;
+
+#define __HAL_UART_GET_FLAG(h, f)      ((((h)->flags) & (f)) == (f))
+#define __HAL_UART_GET_IT_SOURCE(h, i) ((((h)->itSources) & (i)) == (i) ? 1U : 0U)
+
+#define TIM_CHANNEL_1            0x00000000U
+#define TIM_IT_UPDATE            0x00000001U
+#define TIM_IT_CC1               0x00000002U
+
+typedef struct {
+    uint32_t counter;
+    uint32_t compare1;
+    uint32_t autoReload;
+    uint32_t itEnabled;
+    uint8_t enabled;
+} TIM_HandleTypeDef;
+
+#define __HAL_TIM_ENABLE(h)              ((h)->enabled = 1U)
+#define __HAL_TIM_DISABLE(h)             ((h)->enabled = 0U)
+#define __HAL_TIM_ENABLE_IT(h, i)        ((h)->itEnabled |= (i))
+#define __HAL_TIM_DISABLE_IT(h, i)       ((h)->itEnabled &= ~(uint32_t)(i))
+#define __HAL_TIM_CLEAR_IT(h, i)         ((void)(h), (void)(i))
+#define __HAL_TIM_SET_COUNTER(h, c)      ((h)->counter = (c))
+#define __HAL_TIM_SET_COMPARE(h, ch, c)  ((void)(ch), (h)->compare1 = (c))
+#define __HAL_TIM_SET_AUTORELOAD(h, a)   ((h)->autoReload = (a))
+
+// Core peripherals
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type halStubDwt;
+extern CoreDebug_Type halStubCoreDebug;
+#define DWT                      (&halStubDwt)
+#define CoreDebug                (&halStubCoreDebug)
+#define DWT_CTRL_CYCCNTENA_Msk   0x00000001U
+#define CoreDebug_DEMCR_TRCENA_Msk 0x01000000U
+
+extern uint32_t SystemCoreClock;
+
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+void __disable_irq(void);
+void __enable_irq(void);
+void __DMB(void);
+
+uint32_t HAL_GetTick(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+uint32_t HAL_UARTEx_GetRxEventType(UART_HandleTypeDef *huart);
+
+// Callbacks the firmware implements
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // STM32F4XX_HAL_H
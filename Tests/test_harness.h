@@ -0,0 +1,40 @@
+
+
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+/*
+ * test_harness.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: arunp
+ */
+
+#include <stdio.h>
+
+// Minimal checks for the host tests: failures are printed and counted, and
+// main returns TEST_RESULT() so make stops on the first failing binary
+static int testFailures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        long long va = (long long)(a); \
+        long long vb = (long long)(b); \
+        if (va != vb) { \
+            printf("%s:%d: CHECK_EQ failed: %s == %s (0x%llX != 0x%llX)\n", __FILE__, __LINE__, #a, #b, va, vb); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define TEST_RESULT() \
+    (printf("%s\n", testFailures ? "FAILED" : "OK"), testFailures ? 1 : 0)
+
+#endif  // TEST_HARNESS_H
@@ -0,0 +1,88 @@
+/*
+* test_modbus_crc.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+#include <stdint.h>
+#include "modbus_crc.h"
+#include "test_harness.h"
+
+#define PATTERN_LENGTH           300    // Longer than any RTU frame
+
+static uint8_t pattern[PATTERN_LENGTH];
+
+
+static void FillPattern(void) {
+    uint16_t seed = 0x1D0F;
+
+    for (uint16_t i = 0; i < PATTERN_LENGTH; i++) {
+        seed = (uint16_t)(seed * 25173 + 13849);
+        pattern[i] = (uint8_t)(seed >> 8);
+    }
+}
+
+static void TestCheckValues(void) {
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    // Read holding registers 0..9 of slave 1, CRC sent as C5 CD
+    const uint8_t request[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A };
+
+    CHECK_EQ(Modbus_CalculateCRC(check, sizeof(check)), 0x4B37);
+    CHECK_EQ(Modbus_CalculateCRC(request, sizeof(request)), 0xCDC5);
+    CHECK_EQ(Modbus_CalculateCRC(request, 0), MODBUS_CRC_INIT);
+}
+
+static void TestBackendsMatchBitwise(void) {
+    // Every length, so slice-by-4 runs all of its tail cases
+    for (uint16_t length = 0; length <= PATTERN_LENGTH; length++) {
+        uint16_t expected = ModbusCRC_UpdateBitwise(MODBUS_CRC_INIT, pattern, length);
+        CHECK_EQ(ModbusCRC_UpdateNibble(MODBUS_CRC_INIT, pattern, length), expected);
+        CHECK_EQ(ModbusCRC_UpdateTable(MODBUS_CRC_INIT, pattern, length), expected);
+        CHECK_EQ(ModbusCRC_UpdateSlice4(MODBUS_CRC_INIT, pattern, length), expected);
+        CHECK_EQ(ModbusCRC_Update(MODBUS_CRC_INIT, pattern, length), expected);
+    }
+}
+
+static void TestUnalignedStart(void) {
+    for (uint16_t offset = 1; offset < 4; offset++) {
+        uint16_t length = PATTERN_LENGTH - offset;
+        CHECK_EQ(ModbusCRC_UpdateSlice4(MODBUS_CRC_INIT, &pattern[offset], length),
+                 ModbusCRC_UpdateBitwise(MODBUS_CRC_INIT, &pattern[offset], length));
+    }
+}
+
+static void TestSplitUpdates(void) {
+    // The RX path feeds DMA chunks as they arrive; any split must equal one pass
+    const uint16_t length = 64;
+    uint16_t expected = ModbusCRC_UpdateBitwise(MODBUS_CRC_INIT, pattern, length);
+
+    for (uint16_t split = 0; split <= length; split++) {
+        uint16_t crc = ModbusCRC_Update(MODBUS_CRC_INIT, pattern, split);
+        CHECK_EQ(ModbusCRC_Update(crc, &pattern[split], length - split), expected);
+    }
+}
+
+static void TestFrameResidue(void) {
+    // A frame with its CRC appended low byte first checks to zero
+    uint8_t frame[PATTERN_LENGTH + 2];
+
+    for (uint16_t i = 0; i < PATTERN_LENGTH; i++) {
+        frame[i] = pattern[i];
+    }
+    uint16_t crc = Modbus_CalculateCRC(frame, PATTERN_LENGTH);
+    frame[PATTERN_LENGTH] = (uint8_t)(crc & 0xFF);
+    frame[PATTERN_LENGTH + 1] = (uint8_t)(crc >> 8);
+    CHECK_EQ(Modbus_CalculateCRC(frame, sizeof(frame)), 0);
+}
+
+int main(void) {
+    printf("CRC backend %d\n", MODBUS_CRC_BACKEND);
+    FillPattern();
+    TestCheckValues();
+    TestBackendsMatchBitwise();
+    TestUnalignedStart();
+    TestSplitUpdates();
+    TestFrameResidue();
+    return TEST_RESULT();
+}
@@ -0,0 +1,152 @@
+/*
+* test_modbus_estop.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+// Worst-case e-stop latency: with every other lane full and a request on
+// the wire, Motor_EmergencyStop must be the very next frame out, after
+// nothing more than the in-flight transaction and its reply window.
+
+#include <stdint.h>
+#include <string.h>
+#include "hal_stub.h"
+#include "modbus_rtu.h"
+#include "modbus_master.h"
+#include "modbus_motor.h"
+#include "modbus_crc.h"
+#include "test_harness.h"
+
+#define FRAME_US                 700    // One 8-byte request at 115200 baud
+
+static HalStub_Port mainPort;
+static HalStub_Port auxPort;
+
+
+static void Setup(void) {
+    HalStub_InitPort(&mainPort, USART6, 115200);
+    HalStub_InitPort(&auxPort, USART2, 115200);
+    ModbusRTU_Init(MODBUS_BUS_MAIN, &mainPort.huart, &mainPort.htim);
+    ModbusRTU_Init(MODBUS_BUS_AUX, &auxPort.huart, &auxPort.htim);
+    Motor_InitAxes();
+}
+
+// Slave IDs encode lane and order, so the wire order can be checked later
+static HAL_StatusTypeDef QueueRead(uint8_t bus, uint8_t priority, uint8_t seq) {
+    Modbus_Request request = { (uint8_t)(priority * 10 + seq + 1), MODBUS_READ_HOLDING_REG, REG_STATUS, 1, NULL,
+                               priority, bus, 0, 0 };
+    return Modbus_QueueRequest(&request);
+}
+
+static uint8_t IsBroadcastStop(const HalStub_Tx *tx) {
+    uint8_t expected[8] = { MODBUS_BROADCAST_ID, MODBUS_WRITE_SINGLE_REG, REG_START_STOP >> 8, REG_START_STOP & 0xFF,
+                            0x00, 0x00, 0, 0 };
+    uint16_t crc = Modbus_CalculateCRC(expected, 6);
+
+    expected[6] = (uint8_t)(crc & 0xFF);
+    expected[7] = (uint8_t)(crc >> 8);
+    return tx->length == sizeof(expected) && memcmp(tx->data, expected, sizeof(expected)) == 0;
+}
+
+// Ends the frame on the wire, then lets its hold run out with no reply
+static void FinishTransaction(HalStub_Port *port) {
+    HalStub_AdvanceCycles(FRAME_US * HAL_STUB_CYCLES_PER_US);
+    HalStub_CompleteTx(port);
+    HalStub_ExpireSilence(port);
+}
+
+static void TestStopIsNextAfterInFlight(void) {
+    ModbusRTU_TxStats stats;
+    uint8_t queued[MODBUS_PRIO_CONTROL + 1] = { 0 };
+
+    Setup();
+
+    // The bus is idle, so the first request goes straight onto the wire
+    CHECK_EQ(QueueRead(MODBUS_BUS_MAIN, MODBUS_PRIO_CONTROL, 0), HAL_OK);
+    CHECK_EQ(mainPort.txCount, 1);
+    queued[MODBUS_PRIO_CONTROL] = 1;
+
+    // Fill every ordinary slot behind it, mixing the lanes
+    uint8_t filled = 0;
+    for (uint8_t i = 0; ; i++) {
+        uint8_t priority = (uint8_t)(i % (MODBUS_PRIO_CONTROL + 1));
+        if (QueueRead(MODBUS_BUS_MAIN, priority, queued[priority]) != HAL_OK) {
+            break;
+        }
+        queued[priority]++;
+        filled++;
+    }
+    CHECK_EQ(filled + 1, MODBUS_TX_FRAME_SLOTS);
+    CHECK_EQ(mainPort.txCount, 1);
+
+    // The in-flight request is never cut short
+    Motor_EmergencyStop();
+    CHECK_EQ(mainPort.txCount, 1);
+    CHECK(!HalStub_IrqMasked());
+
+    // Its end and its reply window are all the stop waits for
+    HalStub_AdvanceCycles(FRAME_US * HAL_STUB_CYCLES_PER_US);
+    HalStub_CompleteTx(&mainPort);
+    CHECK_EQ(mainPort.txCount, 1);
+    uint32_t holdUs = mainPort.htim.autoReload;
+    CHECK(holdUs > ModbusRTU_GetTiming(ModbusRTU_GetBus(MODBUS_BUS_MAIN))->t35Us);
+    HalStub_ExpireSilence(&mainPort);
+    CHECK_EQ(mainPort.txCount, 2);
+    CHECK(IsBroadcastStop(&mainPort.tx[1]));
+
+    ModbusRTU_GetTxStats(ModbusRTU_GetBus(MODBUS_BUS_MAIN), &stats);
+    CHECK_EQ(stats.estopFrames, 1);
+    CHECK_EQ(stats.estopLastUs, FRAME_US + holdUs);
+    CHECK(stats.preemptions >= 1);
+
+    // The idle AUX bus sent its stop at once
+    CHECK_EQ(auxPort.txCount, 1);
+    CHECK(IsBroadcastStop(&auxPort.tx[0]));
+
+    // The rest drain most urgent lane first, FIFO within a lane. Broadcasts
+    // and requests alike hold the bus until their window is over.
+    uint8_t lastPriority = MODBUS_PRIO_ESTOP;
+    uint8_t lastSeq = 0;
+    for (uint8_t n = 0; n < filled; n++) {
+        FinishTransaction(&mainPort);
+        CHECK_EQ(mainPort.txCount, 3 + n);
+        uint8_t id = mainPort.tx[2 + n].data[0];
+        uint8_t priority = (uint8_t)((id - 1) / 10);
+        uint8_t seq = (uint8_t)((id - 1) % 10);
+        CHECK(priority <= lastPriority);
+        if (priority == lastPriority) {
+            CHECK(seq > lastSeq);
+        }
+        lastPriority = priority;
+        lastSeq = seq;
+    }
+}
+
+static void TestStopLaneNeverStarved(void) {
+    Modbus_Request stop = { MODBUS_BROADCAST_ID, MODBUS_WRITE_SINGLE_REG, REG_START_STOP, 0, NULL,
+                            MODBUS_PRIO_ESTOP, MODBUS_BUS_MAIN, 0, 0 };
+
+    Setup();
+    while (QueueRead(MODBUS_BUS_MAIN, MODBUS_PRIO_CONTROL, 0) == HAL_OK) {
+    }
+
+    // Ordinary producers are refused, yet every reserved slot still takes a stop
+    CHECK_EQ(QueueRead(MODBUS_BUS_MAIN, MODBUS_PRIO_DIAG, 0), HAL_BUSY);
+    for (uint8_t i = 0; i < MODBUS_TX_ESTOP_SLOTS; i++) {
+        CHECK_EQ(Modbus_QueueEmergency(&stop), HAL_OK);
+    }
+    CHECK_EQ(Modbus_QueueEmergency(&stop), HAL_BUSY);
+
+    // Both go out back to back once the in-flight transaction is over
+    FinishTransaction(&mainPort);
+    CHECK(IsBroadcastStop(&mainPort.tx[mainPort.txCount - 1]));
+    FinishTransaction(&mainPort);
+    CHECK(IsBroadcastStop(&mainPort.tx[mainPort.txCount - 1]));
+}
+
+int main(void) {
+    TestStopIsNextAfterInFlight();
+    TestStopLaneNeverStarved();
+    return TEST_RESULT();
+}
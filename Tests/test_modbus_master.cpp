@@ -0,0 +1,147 @@
+/*
+* test_modbus_master.cpp
+*
+*  Created on: Oct 17, 2026
+*      Author: arunp
+*/
+
+// Transaction layer against the host HAL: what the master does when the
+// line or the queue is not available, and how replies are matched
+
+#include <stdint.h>
+#include <string.h>
+#include "hal_stub.h"
+#include "modbus_rtu.h"
+#include "modbus_master.h"
+#include "modbus_motor.h"
+#include "test_harness.h"
+
+#define FRAME_US                 700    // One 8-byte request at 115200 baud
+
+static HalStub_Port mainPort;
+static HalStub_Port auxPort;
+
+
+static void Setup(void) {
+    HalStub_InitPort(&mainPort, USART6, 115200);
+    HalStub_InitPort(&auxPort, USART2, 115200);
+    ModbusRTU_Init(MODBUS_BUS_MAIN, &mainPort.huart, &mainPort.htim);
+    ModbusRTU_Init(MODBUS_BUS_AUX, &auxPort.huart, &auxPort.htim);
+    for (uint8_t id = 0; id <= MODBUS_MAX_SLAVE_ID; id++) {
+        Modbus_ResetSlaveStats(MODBUS_BUS_MAIN, id);
+    }
+}
+
+static Modbus_Request ReadRequest(uint8_t slaveID, uint8_t priority) {
+    Modbus_Request request = { slaveID, MODBUS_READ_HOLDING_REG, REG_STATUS, 1, NULL, priority, MODBUS_BUS_MAIN,
+                               0, 0 };
+    return request;
+}
+
+// A request that never gets the line is withdrawn, not sent late where its
+// reply would be taken for the next request's
+static void TestTxWaitCancels(void) {
+    Modbus_Request blocker = ReadRequest(1, MODBUS_PRIO_CONTROL);
+    Modbus_Request request = ReadRequest(2, MODBUS_PRIO_POLL);
+    Modbus_Response response;
+    ModbusRTU_TxStats stats;
+
+    Setup();
+    CHECK_EQ(Modbus_QueueRequest(&blocker), HAL_OK);
+    CHECK_EQ(mainPort.txCount, 1);
+
+    // The blocker's TX never completes, so every attempt waits out the queue
+    CHECK_EQ(Modbus_Transaction(&request, &response), MODBUS_ERR_TIMEOUT);
+    ModbusRTU_GetTxStats(ModbusRTU_GetBus(MODBUS_BUS_MAIN), &stats);
+    CHECK_EQ(stats.cancelled, 1 + MODBUS_MAX_RETRIES);
+    CHECK_EQ(stats.depth, 1);
+
+    HalStub_AdvanceCycles(FRAME_US * HAL_STUB_CYCLES_PER_US);
+    HalStub_CompleteTx(&mainPort);
+    HalStub_ExpireSilence(&mainPort);
+    CHECK_EQ(mainPort.txCount, 1);
+}
+
+// Our own full queue is no reason to hold a healthy drive against it
+static void TestQueueFullIsLocal(void) {
+    Modbus_Request request = ReadRequest(3, MODBUS_PRIO_POLL);
+    Modbus_Response response;
+
+    Setup();
+    for (uint8_t i = 0; i < MODBUS_OFFLINE_AFTER + 1; i++) {
+        Modbus_Request filler = ReadRequest(1, MODBUS_PRIO_DIAG);
+        while (Modbus_QueueRequest(&filler) == HAL_OK) {
+        }
+        CHECK_EQ(Modbus_Transaction(&request, &response), MODBUS_ERR_QUEUE_FULL);
+    }
+    CHECK_EQ(mainPort.txCount, 1);
+
+    const Modbus_SlaveStats *stats = Modbus_GetSlaveStats(MODBUS_BUS_MAIN, 3);
+    CHECK_EQ(stats->timeouts, 0);
+    CHECK_EQ(stats->retries, 0);
+    CHECK_EQ(stats->failures, 0);
+    CHECK_EQ(stats->consecutiveFailures, 0);
+    CHECK_EQ(stats->rtoUs, 0);
+
+    // A batch reports the same for the requests that found no room
+    Modbus_Response responses[2];
+    Modbus_Request batch[2] = { ReadRequest(3, MODBUS_PRIO_POLL), ReadRequest(4, MODBUS_PRIO_POLL) };
+    CHECK_EQ(Modbus_TransactionBatch(batch, responses, 2), 0);
+    CHECK_EQ(responses[0].status, MODBUS_ERR_QUEUE_FULL);
+    CHECK_EQ(responses[1].status, MODBUS_ERR_QUEUE_FULL);
+    CHECK_EQ(stats->failures, 0);
+}
+
+// Nothing follows a broadcast before every slave had time to act on it
+static void TestBroadcastTurnaround(void) {
+    Modbus_Request broadcast = { MODBUS_BROADCAST_ID, MODBUS_WRITE_SINGLE_REG, REG_START_STOP, 1, NULL,
+                                 MODBUS_PRIO_CONTROL, MODBUS_BUS_MAIN, 0, 0 };
+    Modbus_Request next = ReadRequest(1, MODBUS_PRIO_CONTROL);
+    Modbus_Response response;
+
+    Setup();
+    CHECK_EQ(Modbus_Transaction(&broadcast, &response), MODBUS_OK);
+    CHECK_EQ(Modbus_QueueRequest(&next), HAL_OK);
+    CHECK_EQ(mainPort.txCount, 1);
+
+    HalStub_AdvanceCycles(FRAME_US * HAL_STUB_CYCLES_PER_US);
+    HalStub_CompleteTx(&mainPort);
+    CHECK_EQ(mainPort.htim.autoReload, MODBUS_BROADCAST_TURNAROUND_US);
+    HalStub_ExpireSilence(&mainPort);
+    CHECK_EQ(mainPort.txCount, 2);
+    CHECK_EQ(mainPort.tx[1].data[0], 1);
+}
+
+// A refused DMA start frees the line and goes again at the next boundary
+static void TestStartFailureRetries(void) {
+    Modbus_Request request = ReadRequest(1, MODBUS_PRIO_CONTROL);
+    ModbusRTU_Bus *bus = ModbusRTU_GetBus(MODBUS_BUS_MAIN);
+    ModbusRTU_TxStats stats;
+
+    Setup();
+    ModbusRTU_SetDriverEnable(bus, &mainPort.de, 0x0100);
+    mainPort.txRefuse = 2;
+    CHECK_EQ(Modbus_QueueRequest(&request), HAL_OK);
+    CHECK_EQ(mainPort.txCount, 0);
+    CHECK_EQ(mainPort.de.BSRR, 0x0100U << 16U);
+    CHECK(!HalStub_IrqMasked());
+
+    HalStub_ExpireSilence(&mainPort);
+    CHECK_EQ(mainPort.txCount, 0);
+    HalStub_ExpireSilence(&mainPort);
+    CHECK_EQ(mainPort.txCount, 1);
+    CHECK_EQ(mainPort.de.BSRR, 0x0100U);
+    CHECK_EQ(mainPort.tx[0].data[0], 1);
+
+    ModbusRTU_GetTxStats(bus, &stats);
+    CHECK_EQ(stats.startFailures, 2);
+    CHECK_EQ(stats.depth, 1);
+}
+
+int main(void) {
+    TestTxWaitCancels();
+    TestQueueFullIsLocal();
+    TestBroadcastTurnaround();
+    TestStartFailureRetries();
+    return TEST_RESULT();
+}